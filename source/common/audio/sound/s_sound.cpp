@@ -44,6 +44,7 @@
 #include "m_random.h"
 #include "printf.h"
 #include "c_cvars.h"
+#include "filesystem.h"
 
 CVARD(Bool, snd_enabled, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG, "enables/disables sound effects")
 
@@ -138,6 +139,18 @@ void SoundEngine::CacheMarkedSounds()
 		MarkUsed(chan->SoundID);
 	}
 
+	// Let the worker pool decompress the sound lumps that still need loading.
+	TArray<int> lumps;
+	for (unsigned i = 1; i < S_sfx.Size(); ++i)
+	{
+		if (S_sfx[i].bUsed && !S_sfx[i].data.isValid() && S_sfx[i].lumpnum >= 0)
+		{
+			lumps.Push(S_sfx[i].lumpnum);
+		}
+	}
+	auto prefetch = fileSystem.Prefetch(lumps);
+	prefetch.Wait();
+
 	for (unsigned i = 1; i < S_sfx.Size(); ++i)
 	{
 		if (S_sfx[i].bUsed)
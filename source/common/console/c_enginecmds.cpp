@@ -52,6 +52,9 @@
 #include "version.h"
 #include "findfile.h"
 #include "md5.h"
+#include "i_time.h"
+#include "c_cvars.h"
+#include "templates.h"
 
 extern FILE* Logfile;
 
@@ -336,3 +339,98 @@ CCMD(printlocalized)
 	}
 
 }
+
+//==========================================================================
+//
+// CCMD lumpbench
+//
+// Times the lump name lookups against a synthetic load order.
+//
+//==========================================================================
+
+CCMD(lumpbench)
+{
+	int numlumps = argv.argc() > 1 ? MAX(atoi(argv[1]), 1000) : 100000;
+	const int numlookups = 1000000;
+
+	// A mix of WAD style short names and zip paths, with some names overridden by later lumps.
+	auto makename = [](int i) -> FString
+	{
+		switch (i & 3)
+		{
+		default:
+		case 0: return FStringf("LMP%05d", i % 100000);
+		case 1: return FStringf("textures/tx%06d.png", i);
+		case 2: return FStringf("sounds/sn%06d.ogg", i);
+		case 3: return FStringf("maps/m%06d.map", i);
+		}
+	};
+
+	auto fs = std::make_unique<FileSystem>();
+	static const char dummy = 0;
+	for (int i = 0; i < numlumps; i++)
+	{
+		auto lump = new FMemoryLump(&dummy, 1);
+		int n = i < numlumps * 9 / 10 ? i : i - numlumps * 9 / 10;
+		lump->LumpNameSetup(makename(n));
+		if ((n & 3) == 0) lump->Flags = LUMPF_SHORTNAME;
+		fs->AddLump(lump);
+	}
+
+	uint64_t start = I_nsTime();
+	fs->InitHashChains();
+	uint64_t inittime = I_nsTime() - start;
+
+	TArray<FString> names(numlookups / 100, true);
+	TArray<FString> missing(numlookups / 100, true);
+	TArray<FString> noext(numlookups / 100, true);
+	for (unsigned i = 0; i < names.Size(); i++)
+	{
+		names[i] = makename((int)(((uint64_t)i * 7919) % numlumps));
+		missing[i] = makename(numlumps + i) + "x";
+		noext[i] = names[i];
+		auto dot = noext[i].LastIndexOf('.');
+		if (dot >= 0) noext[i].Truncate(dot);
+	}
+
+	auto bench = [&](const char* label, TArray<FString>& list, auto&& lookup)
+	{
+		int found = 0;
+		uint64_t start = I_nsTime();
+		for (int i = 0; i < numlookups; i++)
+		{
+			found += lookup(list[i % list.Size()]) >= 0;
+		}
+		uint64_t elapsed = I_nsTime() - start;
+		Printf("%-28s %7.1f ns/lookup (%d found)\n", label, elapsed / (double)numlookups, found);
+	};
+
+	Printf("%d lumps, hash tables built in %.2f ms\n", numlumps, inittime / 1000000.0);
+	bench("CheckNumForName (hit)", names, [&](const FString& n) { return fs->CheckNumForName(n.GetChars(), ns_global); });
+	bench("CheckNumForName (miss)", missing, [&](const FString& n) { return fs->CheckNumForName(n.GetChars(), ns_global); });
+	bench("CheckNumForFullName (hit)", names, [&](const FString& n) { return fs->CheckNumForFullName(n.GetChars()); });
+	bench("CheckNumForFullName (miss)", missing, [&](const FString& n) { return fs->CheckNumForFullName(n.GetChars()); });
+	bench("CheckNumForFullName (no ext)", noext, [&](const FString& n) { return fs->CheckNumForFullName(n.GetChars(), false, ns_global, true); });
+}
+
+//==========================================================================
+//
+// Lump cache budget and statistics
+//
+//==========================================================================
+
+CUSTOM_CVAR(Int, lumpcachesize, 64, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else LumpCache_SetBudget((size_t)self * 1024 * 1024);
+}
+
+CCMD(lumpcachestats)
+{
+	auto stats = LumpCache_GetStats();
+	uint64_t lookups = stats.Hits + stats.Misses;
+	Printf("Hits: %llu (%.1f%%), misses: %llu, evictions: %llu\n", (unsigned long long)stats.Hits,
+		lookups ? stats.Hits * 100.0 / lookups : 0.0, (unsigned long long)stats.Misses, (unsigned long long)stats.Evictions);
+	Printf("Resident: %.2f MB, of which unreferenced: %.2f MB, budget: %.2f MB\n", stats.ResidentBytes / 1048576.0,
+		stats.UnusedBytes / 1048576.0, stats.Budget / 1048576.0);
+}
@@ -0,0 +1,161 @@
+/*
+** startupstats.cpp
+** Hierarchical wall and CPU time report for the startup phases
+**
+**---------------------------------------------------------------------------
+** Copyright 2021 Raze developers
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <time.h>
+#include <memory>
+#include "startupstats.h"
+#include "tarray.h"
+#include "zstring.h"
+#include "files.h"
+#include "printf.h"
+#include "m_argv.h"
+#include "i_time.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+struct FStartupPhaseInfo
+{
+	const char *Name;
+	int Parent;
+	int Depth;
+	uint64_t WallStart, WallTime;
+	uint64_t CPUStart, CPUTime;
+};
+
+static TArray<FStartupPhaseInfo> Phases;
+static int CurrentPhase = -1;
+static bool Reported;
+
+//==========================================================================
+//
+// CPU time used by the whole process in ns. clock() cannot be used for
+// this because on Windows it returns the elapsed wall time.
+//
+//==========================================================================
+
+static uint64_t ProcessCPUTime()
+{
+#ifdef _WIN32
+	FILETIME creationtime, exittime, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationtime, &exittime, &kernel, &user)) return 0;
+	uint64_t k = (uint64_t(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+	uint64_t u = (uint64_t(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+	return (k + u) * 100;	// FILETIME is in 100 ns units
+#else
+	timespec ts;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0;
+	return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+FStartupPhase::FStartupPhase(const char *name)
+{
+	Index = Phases.Reserve(1);
+	auto &phase = Phases[Index];
+	phase.Name = name;
+	phase.Parent = CurrentPhase;
+	phase.Depth = CurrentPhase < 0 ? 0 : Phases[CurrentPhase].Depth + 1;
+	phase.WallTime = 0;
+	phase.CPUTime = 0;
+	phase.CPUStart = ProcessCPUTime();
+	phase.WallStart = I_nsTime();
+	CurrentPhase = Index;
+}
+
+FStartupPhase::~FStartupPhase()
+{
+	auto &phase = Phases[Index];
+	phase.WallTime = I_nsTime() - phase.WallStart;
+	phase.CPUTime = ProcessCPUTime() - phase.CPUStart;
+	CurrentPhase = phase.Parent;
+}
+
+//==========================================================================
+//
+// -startupstats prints the phase tree to the console.
+// -startupstats <file> additionally writes it as JSON.
+//
+// CPU time is for the whole process, so it includes worker threads and
+// can exceed the wall time.
+//
+//==========================================================================
+
+static double CPUms(uint64_t time)
+{
+	return time / 1e6;
+}
+
+static void WriteJSONChildren(FString &out, int parent, int depth)
+{
+	bool first = true;
+	for (unsigned i = 0; i < Phases.Size(); i++)
+	{
+		auto &phase = Phases[i];
+		if (phase.Parent != parent) continue;
+		int indent = (depth + 1) * 2;
+		out.AppendFormat("%s\n%*s{ \"name\": \"%s\", \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"children\": [", first ? "" : ",",
+			indent, "", phase.Name, phase.WallTime / 1e6, CPUms(phase.CPUTime));
+		auto len = out.Len();
+		WriteJSONChildren(out, i, depth + 1);
+		if (out.Len() != len) out.AppendFormat("\n%*s", indent, "");
+		out += "] }";
+		first = false;
+	}
+}
+
+void StartupStats_Report()
+{
+	if (Reported) return;
+	Reported = true;
+	if (!Args->CheckParm("-startupstats")) return;
+
+	Printf("Startup times (wall / CPU):\n");
+	for (auto &phase : Phases)
+	{
+		Printf("%*s%-*s %9.2f ms %9.2f ms\n", phase.Depth * 2, "", 32 - phase.Depth * 2, phase.Name, phase.WallTime / 1e6, CPUms(phase.CPUTime));
+	}
+
+	const char *jsonfile = Args->CheckValue("-startupstats");
+	if (jsonfile)
+	{
+		FString out = "[";
+		WriteJSONChildren(out, -1, 0);
+		out += "\n]\n";
+		std::unique_ptr<FileWriter> fw(FileWriter::Open(jsonfile));
+		if (fw) fw->Write(out.GetChars(), out.Len());
+		else Printf("Unable to write %s\n", jsonfile);
+	}
+}
@@ -35,6 +35,11 @@
 
 #include "v_colortables.h"
 #include "colormatcher.h"
+#include "files.h"
+#include "cmdlib.h"
+#include "m_argv.h"
+#include "m_crc32.h"
+#include "i_specialpaths.h"
 
 uint32_t Col2RGB8[65][256];
 uint32_t *Col2RGB8_LessPrecision[65];
@@ -45,6 +50,55 @@ ColorTable256k RGB256k;
 
 
 
+//==========================================================================
+//
+// The inverse palette tables take several hundred thousand best color
+// searches to build, but only depend on the palette, so they get cached
+// on disk, keyed by the palette's CRC. Increase TransTableVersion whenever
+// the way the tables are built changes, so that old files get rebuilt.
+//
+//==========================================================================
+
+static const char TransTableMagic[4] = { 'Z', 'D', 'C', 'T' };
+enum { TransTableVersion = 1 };
+
+static FString TransTableCacheName(uint32_t key, bool create)
+{
+	FString path = M_GetCachePath(create);
+	if (create) CreatePath(path);
+	path.AppendFormat("/colortables_%08x.zdct", key);
+	return path;
+}
+
+static bool LoadTransTableCache(uint32_t key)
+{
+	FileReader fr;
+	if (!fr.OpenFile(TransTableCacheName(key, false))) return false;
+	if (fr.GetLength() != long(12 + sizeof(RGB32k) + sizeof(RGB256k))) return false;
+
+	char magic[4];
+	if (fr.Read(magic, 4) != 4 || memcmp(magic, TransTableMagic, 4)) return false;
+	if (fr.ReadUInt32() != TransTableVersion || fr.ReadUInt32() != key) return false;
+	return fr.Read(RGB32k.All, sizeof(RGB32k)) == sizeof(RGB32k) && fr.Read(RGB256k.All, sizeof(RGB256k)) == sizeof(RGB256k);
+}
+
+static void SaveTransTableCache(uint32_t key)
+{
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(TransTableCacheName(key, true)));
+	if (fw == nullptr) return;
+
+	auto put32 = [&](uint32_t v)
+	{
+		uint8_t bytes[4] = { uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24) };
+		fw->Write(bytes, 4);
+	};
+	fw->Write(TransTableMagic, 4);
+	put32(TransTableVersion);
+	put32(key);
+	fw->Write(RGB32k.All, sizeof(RGB32k));
+	fw->Write(RGB256k.All, sizeof(RGB256k));
+}
+
 //==========================================================================
 //
 // BuildTransTable
@@ -52,22 +106,38 @@ ColorTable256k RGB256k;
 // Build the tables necessary for blending - used by software rendering and
 // texture composition
 //
+// The color matcher must already be set to the same palette.
+//
 //==========================================================================
 
 void BuildTransTable (const PalEntry *palette)
 {
 	int r, g, b;
-	
-	// create the RGB555 lookup table
-	for (r = 0; r < 32; r++)
-		for (g = 0; g < 32; g++)
-			for (b = 0; b < 32; b++)
-				RGB32k.RGB[r][g][b] = ColorMatcher.Pick ((r<<3)|(r>>2), (g<<3)|(g>>2), (b<<3)|(b>>2));
-	// create the RGB666 lookup table
-	for (r = 0; r < 64; r++)
-		for (g = 0; g < 64; g++)
-			for (b = 0; b < 64; b++)
-				RGB256k.RGB[r][g][b] = ColorMatcher.Pick ((r<<2)|(r>>4), (g<<2)|(g>>4), (b<<2)|(b>>4));
+	uint8_t rgb[768];
+	for (int i = 0; i < 256; i++)
+	{
+		rgb[i * 3] = palette[i].r;
+		rgb[i * 3 + 1] = palette[i].g;
+		rgb[i * 3 + 2] = palette[i].b;
+	}
+	uint32_t key = CalcCRC32(rgb, sizeof(rgb));
+	bool nocache = Args->CheckParm("-nopalcache");
+
+	if (nocache || !LoadTransTableCache(key))
+	{
+		// create the RGB555 lookup table
+		for (r = 0; r < 32; r++)
+			for (g = 0; g < 32; g++)
+				for (b = 0; b < 32; b++)
+					RGB32k.RGB[r][g][b] = ColorMatcher.Pick ((r<<3)|(r>>2), (g<<3)|(g>>2), (b<<3)|(b>>2));
+		// create the RGB666 lookup table
+		for (r = 0; r < 64; r++)
+			for (g = 0; g < 64; g++)
+				for (b = 0; b < 64; b++)
+					RGB256k.RGB[r][g][b] = ColorMatcher.Pick ((r<<2)|(r>>4), (g<<2)|(g>>4), (b<<2)|(b>>4));
+
+		if (!nocache) SaveTransTableCache(key);
+	}
 	
 	int x, y;
 	
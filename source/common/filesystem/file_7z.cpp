@@ -40,6 +40,8 @@
 #include "resourcefile.h"
 #include "cmdlib.h"
 #include "printf.h"
+#include "templates.h"
+#include "ctpl.h"
 
 
 
@@ -103,61 +105,192 @@ struct CZDFileInStream
 	}
 };
 
-struct C7zArchive
+//-----------------------------------------------------------------------
+//
+// Solid archives pack many files into one block which can only be
+// decompressed as a whole, so decoded blocks are kept around to serve
+// all their files. If many blocks are needed at once and the archive
+// is in memory, they get decoded in parallel.
+//
+//-----------------------------------------------------------------------
+
+enum { BlockCacheSize = 64 * 1024 * 1024 };
+
+struct C7zLookStream
 {
-	CSzArEx DB;
 	CZDFileInStream ArchiveStream;
 	CLookToRead2 LookStream;
 	Byte StreamBuffer[1<<14];
-	UInt32 BlockIndex;
-	Byte *OutBuffer;
-	size_t OutBufferSize;
 
-	C7zArchive(FileReader &file) : ArchiveStream(file)
+	C7zLookStream(FileReader &file) : ArchiveStream(file)
 	{
-		if (g_CrcTable[1] == 0)
-		{
-			CrcGenerateTable();
-		}
 		file.Seek(0, FileReader::SeekSet);
 		LookToRead2_CreateVTable(&LookStream, false);
 		LookStream.realStream = &ArchiveStream.s;
 		LookToRead2_Init(&LookStream);
 		LookStream.bufSize = sizeof(StreamBuffer);
 		LookStream.buf = StreamBuffer;
+	}
+};
+
+struct C7zArchive
+{
+	struct DecodedBlock
+	{
+		Byte *Data;
+		size_t Size;
+		uint64_t LastUse;
+	};
+
+	CSzArEx DB;
+	FileReader &File;
+	C7zLookStream Stream;
+	TMap<UInt32, DecodedBlock> Blocks;
+	size_t CachedBytes = 0;
+	uint64_t UseCounter = 0;
+
+	C7zArchive(FileReader &file) : File(file), Stream(file)
+	{
+		if (g_CrcTable[1] == 0)
+		{
+			CrcGenerateTable();
+		}
 		SzArEx_Init(&DB);
-		BlockIndex = 0xFFFFFFFF;
-		OutBuffer = NULL;
-		OutBufferSize = 0;
 	}
 
 	~C7zArchive()
 	{
-		if (OutBuffer != NULL)
+		decltype(Blocks)::Iterator it(Blocks);
+		decltype(Blocks)::Pair *pair;
+		while (it.NextPair(pair))
 		{
-			IAlloc_Free(&g_Alloc, OutBuffer);
+			IAlloc_Free(&g_Alloc, pair->Value.Data);
 		}
 		SzArEx_Free(&DB, &g_Alloc);
 	}
 
 	SRes Open()
 	{
-		return SzArEx_Open(&DB, &LookStream.vt, &g_Alloc, &g_Alloc);
+		return SzArEx_Open(&DB, &Stream.LookStream.vt, &g_Alloc, &g_Alloc);
 	}
 
-	SRes Extract(UInt32 file_index, char *buffer)
+	SRes DecodeBlock(UInt32 folderIndex, ILookInStream *stream, DecodedBlock &block)
 	{
-		size_t offset, out_size_processed;
-		SRes res = SzArEx_Extract(&DB, &LookStream.vt, file_index,
-			&BlockIndex, &OutBuffer, &OutBufferSize,
-			&offset, &out_size_processed,
-			&g_Alloc, &g_Alloc);
-		if (res == SZ_OK)
+		UInt64 unpackSizeSpec = SzAr_GetFolderUnpackSize(&DB.db, folderIndex);
+		block.Size = (size_t)unpackSizeSpec;
+		block.Data = nullptr;
+		block.LastUse = 0;
+		if (block.Size != unpackSizeSpec) return SZ_ERROR_MEM;
+		if (block.Size == 0) return SZ_OK;
+
+		block.Data = (Byte *)IAlloc_Alloc(&g_Alloc, block.Size);
+		if (block.Data == nullptr) return SZ_ERROR_MEM;
+
+		SRes res = SzAr_DecodeFolder(&DB.db, folderIndex, stream, DB.dataPos, block.Data, block.Size, &g_Alloc);
+		if (res != SZ_OK)
 		{
-			memcpy(buffer, OutBuffer + offset, out_size_processed);
+			IAlloc_Free(&g_Alloc, block.Data);
+			block.Data = nullptr;
 		}
 		return res;
 	}
+
+	void AddBlock(UInt32 folderIndex, const DecodedBlock &block)
+	{
+		Blocks.Insert(folderIndex, block);
+		CachedBytes += block.Size;
+
+		// Evict the least recently used blocks, but always keep the newest one.
+		while (CachedBytes > BlockCacheSize && Blocks.CountUsed() > 1)
+		{
+			decltype(Blocks)::Iterator it(Blocks);
+			decltype(Blocks)::Pair *pair, *oldest = nullptr;
+			while (it.NextPair(pair))
+			{
+				if (pair->Key != folderIndex && (oldest == nullptr || pair->Value.LastUse < oldest->Value.LastUse)) oldest = pair;
+			}
+			CachedBytes -= oldest->Value.Size;
+			IAlloc_Free(&g_Alloc, oldest->Value.Data);
+			Blocks.Remove(oldest->Key);
+		}
+	}
+
+	SRes Extract(UInt32 file_index, char *buffer)
+	{
+		UInt32 folderIndex = DB.FileToFolder[file_index];
+		if (folderIndex == (UInt32)-1) return SZ_OK;	// empty file
+
+		auto block = Blocks.CheckKey(folderIndex);
+		if (block == nullptr)
+		{
+			DecodedBlock newblock;
+			SRes res = DecodeBlock(folderIndex, &Stream.LookStream.vt, newblock);
+			if (res != SZ_OK) return res;
+			newblock.LastUse = ++UseCounter;
+			AddBlock(folderIndex, newblock);
+			block = Blocks.CheckKey(folderIndex);
+		}
+		block->LastUse = ++UseCounter;
+
+		UInt64 unpackPos = DB.UnpackPositions[file_index];
+		size_t offset = (size_t)(unpackPos - DB.UnpackPositions[DB.FolderToFile[folderIndex]]);
+		size_t size = (size_t)(DB.UnpackPositions[file_index + 1] - unpackPos);
+		if (offset + size > block->Size) return SZ_ERROR_FAIL;
+		if (SzBitWithVals_Check(&DB.CRCs, file_index) && CrcCalc(block->Data + offset, size) != DB.CRCs.Vals[file_index])
+			return SZ_ERROR_CRC;
+
+		memcpy(buffer, block->Data + offset, size);
+		return SZ_OK;
+	}
+
+	void DecodeBlocks(const TArray<UInt32> &folders)
+	{
+		// Only decode as many blocks as the cache can hold. Anything beyond that would evict
+		// earlier results before they get used, so those are left to Extract.
+		TArray<UInt32> missing;
+		UInt64 batchsize = 0;
+		for (auto folderIndex : folders)
+		{
+			if (folderIndex != (UInt32)-1 && !Blocks.CheckKey(folderIndex) && missing.Find(folderIndex) == missing.Size())
+			{
+				UInt64 size = SzAr_GetFolderUnpackSize(&DB.db, folderIndex);
+				if (missing.Size() > 0 && batchsize + size > BlockCacheSize) break;
+				batchsize += size;
+				missing.Push(folderIndex);
+			}
+		}
+
+		// Parallel decoding needs a separate stream per thread, which is only cheap when the archive is in memory.
+		auto archivedata = File.GetBuffer();
+		if (missing.Size() < 2 || archivedata == nullptr) return;
+
+		TArray<DecodedBlock> decoded(missing.Size(), true);
+		TArray<SRes> results(missing.Size(), true);
+		{
+			int numthreads = MIN<int>(std::max<int>(std::thread::hardware_concurrency(), 1), missing.Size());
+			ctpl::thread_pool pool(numthreads);
+			auto length = File.GetLength();
+			for (unsigned i = 0; i < missing.Size(); i++)
+			{
+				pool.push([&, i](int)
+				{
+					FileReader mem;
+					mem.OpenMemory(archivedata, length);
+					auto stream = std::make_unique<C7zLookStream>(mem);
+					results[i] = DecodeBlock(missing[i], &stream->LookStream.vt, decoded[i]);
+				});
+			}
+		}
+		// Failed blocks are left to Extract, which reports the error through the regular path.
+		for (unsigned i = 0; i < missing.Size(); i++)
+		{
+			if (results[i] == SZ_OK)
+			{
+				decoded[i].LastUse = ++UseCounter;
+				AddBlock(missing[i], decoded[i]);
+			}
+		}
+	}
 };
 //==========================================================================
 //
@@ -192,6 +325,7 @@ public:
 	bool Open(bool quiet, LumpFilterInfo* filter);
 	virtual ~F7ZFile();
 	virtual FResourceLump *GetLump(int no) { return ((unsigned)no < NumLumps)? &Lumps[no] : NULL; }
+	virtual void PrefetchLumps(const TArray<FResourceLump *> &lumps);
 };
 
 
@@ -336,6 +470,23 @@ F7ZFile::~F7ZFile()
 	}
 }
 
+//==========================================================================
+//
+// Decodes the solid blocks of all requested lumps up front
+//
+//==========================================================================
+
+void F7ZFile::PrefetchLumps(const TArray<FResourceLump *> &lumps)
+{
+	if (Archive == nullptr) return;
+	TArray<UInt32> folders;
+	for (auto lump : lumps)
+	{
+		folders.Push(Archive->DB.FileToFolder[static_cast<F7ZLump *>(lump)->Position]);
+	}
+	Archive->DecodeBlocks(folders);
+}
+
 //==========================================================================
 //
 // Fills the lump cache and performs decompression
@@ -50,7 +50,7 @@
 //
 //==========================================================================
 
-static bool UncompressZipLump(char *Cache, FileReader &Reader, int Method, int LumpSize, int CompressedSize, int GPFlags)
+static bool UncompressZipLump(char *Cache, FileReader &Reader, int Method, int LumpSize, int CompressedSize, int GPFlags, bool quiet = false)
 {
 	try
 	{
@@ -95,17 +95,17 @@ static bool UncompressZipLump(char *Cache, FileReader &Reader, int Method, int L
 	}
 	catch (CRecoverableError &err)
 	{
-		Printf("%s\n", err.GetMessage());
+		if (!quiet) Printf("%s\n", err.GetMessage());
 		return false;
 	}
 	return true;
 }
 
-bool FCompressedBuffer::Decompress(char *destbuffer)
+bool FCompressedBuffer::Decompress(char *destbuffer, bool quiet)
 {
 	FileReader mr;
 	mr.OpenMemory(mBuffer, mCompressedSize);
-	return UncompressZipLump(destbuffer, mr, mMethod, mSize, mCompressedSize, mZipFlags);
+	return UncompressZipLump(destbuffer, mr, mMethod, mSize, mCompressedSize, mZipFlags, quiet);
 }
 
 //-----------------------------------------------------------------------
@@ -172,12 +172,36 @@ FZipFile::FZipFile(const char * filename, FileReader &file)
 
 bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 {
+	Lumps = NULL;
+
+	auto cached = DirCache_Find(FileName, Reader, filter);
+	if (cached != nullptr)
+	{
+		NumLumps = cached->Lumps.Size();
+		Lumps = new FZipLump[NumLumps];
+		for (uint32_t i = 0; i < NumLumps; i++)
+		{
+			auto &info = cached->Lumps[i];
+			FZipLump *lump_p = &Lumps[i];
+			lump_p->LumpNameSetup(info.Name);
+			lump_p->LumpSize = info.LumpSize;
+			lump_p->Owner = this;
+			lump_p->Flags = info.Flags;
+			lump_p->NeedFileStart = true;
+			lump_p->Method = info.Method;
+			lump_p->GPFlags = info.GPFlags;
+			lump_p->CRC32 = info.CRC32;
+			lump_p->CompressedSize = info.CompressedSize;
+			lump_p->Position = info.Position;
+		}
+		Hash = cached->Hash;
+		return true;
+	}
+
 	uint32_t centraldir = Zip_FindCentralDir(Reader);
 	FZipEndOfCentralDirectory info;
 	int skipped = 0;
 
-	Lumps = NULL;
-
 	if (centraldir == 0)
 	{
 		if (!quiet) Printf(TEXTCOLOR_RED "\n%s: ZIP file corrupt!\n", FileName.GetChars());
@@ -347,6 +371,26 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 
 	GenerateHash();
 	PostProcessArchive(&Lumps[0], sizeof(FZipLump), filter);
+
+	cached = DirCache_Add(FileName, Reader, filter);
+	if (cached != nullptr)
+	{
+		cached->Hash = Hash;
+		cached->Lumps.Resize(NumLumps);
+		for (uint32_t i = 0; i < NumLumps; i++)
+		{
+			auto &info = cached->Lumps[i];
+			FZipLump *lump_p = &Lumps[i];
+			info.Name = lump_p->getName();
+			info.LumpSize = lump_p->LumpSize;
+			info.Flags = lump_p->Flags;
+			info.Method = lump_p->Method;
+			info.GPFlags = lump_p->GPFlags;
+			info.CRC32 = lump_p->CRC32;
+			info.CompressedSize = lump_p->CompressedSize;
+			info.Position = lump_p->Position;
+		}
+	}
 	return true;
 }
 
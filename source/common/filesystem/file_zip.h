@@ -20,6 +20,7 @@ struct FZipLump : public FResourceLump
 
 	virtual FileReader *GetReader();
 	virtual int FillCache();
+	virtual bool CanDecodeAsync() const { return Method != METHOD_STORED; }
 
 private:
 	void SetLumpAddress();
@@ -46,6 +46,9 @@
 #include "m_crc32.h"
 #include "printf.h"
 #include "md5.h"
+#include "ctpl.h"
+#include <mutex>
+#include <condition_variable>
 
 extern	FILE* hashfile;
 
@@ -161,7 +164,10 @@ FileSystem::~FileSystem ()
 
 void FileSystem::DeleteAll ()
 {
-	Hashes.Clear();
+	ShortNames.Init(0);
+	FullNames.Init(0);
+	NoExtNames.Init(0);
+	ResIds.Init(0);
 	NumEntries = 0;
 
 	// explicitly delete all manually added lumps.
@@ -223,6 +229,7 @@ void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, Lump
 
 	// [RH] Set up hash table
 	InitHashChains ();
+	DirCache_Save();
 }
 
 //==========================================================================
@@ -303,7 +310,8 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 
 		if (!isdir)
 		{
-			if (!filereader.OpenFile(filename))
+			// Mapped archives let uncompressed lumps be served straight from the file's pages.
+			if (!filereader.OpenFileMapped(filename) && !filereader.OpenFile(filename))
 			{ // Didn't find file
 				if (!quiet)
 				{
@@ -474,12 +482,11 @@ int FileSystem::CheckNumForName (const char *name, int space)
 	}
 
 	uppercopy (uname, name);
-	i = FirstLumpIndex[LumpNameHash (uname) % NumEntries];
+	uint32_t hash = LumpNameHash (uname);
 
-	while (i != NULL_INDEX)
+	for (unsigned slot = ShortNames.Home(hash); (i = ShortNames.Slots[slot].Index) != NULL_INDEX; slot = ShortNames.Next(slot))
 	{
-
-		if (FileInfo[i].shortName.qword == qname)
+		if (ShortNames.Slots[slot].Hash == hash && FileInfo[i].shortName.qword == qname)
 		{
 			auto &lump = FileInfo[i];
 			if (lump.Namespace == space) break;
@@ -491,7 +498,6 @@ int FileSystem::CheckNumForName (const char *name, int space)
 			if (space > ns_specialzipdirectory && lump.Namespace == ns_global && 
 				!((lump.lump->Flags ^lump.flags) & LUMPF_FULLPATH)) break;
 		}
-		i = NextLumpIndex[i];
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -512,16 +518,18 @@ int FileSystem::CheckNumForName (const char *name, int space, int rfnum, bool ex
 	}
 
 	uppercopy (uname, name);
-	i = FirstLumpIndex[LumpNameHash (uname) % NumEntries];
+	uint32_t hash = LumpNameHash (uname);
 
 	// If exact is true if will only find lumps in the same WAD, otherwise
 	// also those in earlier WADs.
 
-	while (i != NULL_INDEX &&
-		(FileInfo[i].shortName.qword != qname || FileInfo[i].Namespace != space ||
-		 (exact? (FileInfo[i].rfnum != rfnum) : (FileInfo[i].rfnum > rfnum)) ))
+	for (unsigned slot = ShortNames.Home(hash); (i = ShortNames.Slots[slot].Index) != NULL_INDEX; slot = ShortNames.Next(slot))
 	{
-		i = NextLumpIndex[i];
+		if (ShortNames.Slots[slot].Hash == hash && FileInfo[i].shortName.qword == qname && FileInfo[i].Namespace == space &&
+			(exact? (FileInfo[i].rfnum == rfnum) : (FileInfo[i].rfnum <= rfnum)))
+		{
+			break;
+		}
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -567,12 +575,13 @@ int FileSystem::CheckNumForFullName (const char *name, bool trynormal, int names
 		return -1;
 	}
 	if (*name == '/') name++;	// ignore leading slashes in file names.
-	uint32_t *fli = ignoreext ? FirstLumpIndex_NoExt : FirstLumpIndex_FullName;
-	uint32_t *nli = ignoreext ? NextLumpIndex_NoExt : NextLumpIndex_FullName;
+	auto &table = ignoreext ? NoExtNames : FullNames;
 	auto len = strlen(name);
+	uint32_t hash = MakeKey(name, len);
 
-	for (i = fli[MakeKey(name) % NumEntries]; i != NULL_INDEX; i = nli[i])
+	for (unsigned slot = table.Home(hash); (i = table.Slots[slot].Index) != NULL_INDEX; slot = table.Next(slot))
 	{
+		if (table.Slots[slot].Hash != hash) continue;
 		if (strnicmp(name, FileInfo[i].longName, len)) continue;
 		if (FileInfo[i].longName[len] == 0) break;	// this is a full match
 		if (ignoreext && FileInfo[i].longName[len] == '.') 
@@ -600,12 +609,11 @@ int FileSystem::CheckNumForFullName (const char *name, int rfnum)
 		return CheckNumForFullName (name);
 	}
 
-	i = FirstLumpIndex_FullName[MakeKey (name) % NumEntries];
+	uint32_t hash = MakeKey (name);
 
-	while (i != NULL_INDEX && 
-		(stricmp(name, FileInfo[i].longName) || FileInfo[i].rfnum != rfnum))
+	for (unsigned slot = FullNames.Home(hash); (i = FullNames.Slots[slot].Index) != NULL_INDEX; slot = FullNames.Next(slot))
 	{
-		i = NextLumpIndex_FullName[i];
+		if (FullNames.Slots[slot].Hash == hash && FileInfo[i].rfnum == rfnum && !stricmp(name, FileInfo[i].longName)) break;
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -648,12 +656,12 @@ int FileSystem::FindFileWithExtensions(const char* name, const char *const *exts
 		return -1;
 	}
 	if (*name == '/') name++;	// ignore leading slashes in file names.
-	uint32_t* fli = FirstLumpIndex_NoExt;
-	uint32_t* nli = NextLumpIndex_NoExt;
 	auto len = strlen(name);
+	uint32_t hash = MakeKey(name, len);
 
-	for (i = fli[MakeKey(name) % NumEntries]; i != NULL_INDEX; i = nli[i])
+	for (unsigned slot = NoExtNames.Home(hash); (i = NoExtNames.Slots[slot].Index) != NULL_INDEX; slot = NoExtNames.Next(slot))
 	{
+		if (NoExtNames.Slots[slot].Hash != hash) continue;
 		if (strnicmp(name, FileInfo[i].longName, len)) continue;
 		if (FileInfo[i].longName[len] != '.') continue;	// we are looking for extensions but this file doesn't have one.
 
@@ -686,11 +694,9 @@ int FileSystem::FindResource (int resid, const char *type, int filenum) const no
 		return -1;
 	}
 
-	uint32_t* fli = FirstLumpIndex_ResId;
-	uint32_t* nli = NextLumpIndex_ResId;
-
-	for (i = fli[resid % NumEntries]; i != NULL_INDEX; i = nli[i])
+	for (unsigned slot = ResIds.Home(resid); (i = ResIds.Slots[slot].Index) != NULL_INDEX; slot = ResIds.Next(slot))
 	{
+		if (ResIds.Slots[slot].Hash != (uint32_t)resid) continue;
 		if (filenum > 0 && FileInfo[i].rfnum != filenum) continue;
 		if (FileInfo[i].resourceId != resid) continue;
 		auto extp = strrchr(FileInfo[i].longName, '.');
@@ -835,51 +841,57 @@ uint32_t FileSystem::LumpNameHash (const char *s)
 //
 //==========================================================================
 
-void FileSystem::InitHashChains (void)
+void FileSystem::LumpHashTable::Init(unsigned count)
+{
+	// Keep the load factor at or below 50% so that probe sequences stay short.
+	int bits = 1;
+	while ((1u << bits) < count * 2) bits++;
+	Shift = 32 - bits;
+	Slots.Resize(1u << bits);
+	// Mark all slots as empty
+	memset(Slots.Data(), -1, Slots.Size() * sizeof(Slots[0]));
+}
+
+void FileSystem::LumpHashTable::Insert(uint32_t hash, uint32_t index)
 {
-	unsigned int i, j;
+	unsigned slot = Home(hash);
+	while (Slots[slot].Index != NULL_INDEX) slot = Next(slot);
+	Slots[slot].Hash = hash;
+	Slots[slot].Index = index;
+}
 
+void FileSystem::InitHashChains (void)
+{
 	NumEntries = FileInfo.Size();
-	Hashes.Resize(8 * NumEntries);
-	// Mark all buckets as empty
-	memset(Hashes.Data(), -1, Hashes.Size() * sizeof(Hashes[0]));
-	FirstLumpIndex = &Hashes[0];
-	NextLumpIndex = &Hashes[NumEntries];
-	FirstLumpIndex_FullName = &Hashes[NumEntries * 2];
-	NextLumpIndex_FullName = &Hashes[NumEntries * 3];
-	FirstLumpIndex_NoExt = &Hashes[NumEntries * 4];
-	NextLumpIndex_NoExt = &Hashes[NumEntries * 5];
-	FirstLumpIndex_ResId = &Hashes[NumEntries * 6];
-	NextLumpIndex_ResId = &Hashes[NumEntries * 7];
-
-
-	// Now set up the chains
-	for (i = 0; i < (unsigned)NumEntries; i++)
-	{
-		j = LumpNameHash (FileInfo[i].shortName.String) % NumEntries;
-		NextLumpIndex[i] = FirstLumpIndex[j];
-		FirstLumpIndex[j] = i;
+
+	unsigned numlongnames = 0;
+	for (unsigned i = 0; i < NumEntries; i++)
+	{
+		if (FileInfo[i].longName.IsNotEmpty()) numlongnames++;
+	}
+	ShortNames.Init(NumEntries);
+	FullNames.Init(numlongnames);
+	NoExtNames.Init(numlongnames);
+	ResIds.Init(numlongnames);
+
+	// Insert from the last lump to the first. Linear probing keeps entries with the
+	// same hash in insertion order, so lookups still find the last added lump first.
+	for (int i = NumEntries - 1; i >= 0; i--)
+	{
+		ShortNames.Insert(LumpNameHash (FileInfo[i].shortName.String), i);
 
 		// Do the same for the full paths
 		if (FileInfo[i].longName.IsNotEmpty())
 		{
-			j = MakeKey(FileInfo[i].longName) % NumEntries;
-			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
-			FirstLumpIndex_FullName[j] = i;
+			FullNames.Insert(MakeKey(FileInfo[i].longName), i);
 
 			FString nameNoExt = FileInfo[i].longName;
 			auto dot = nameNoExt.LastIndexOf('.');
 			auto slash = nameNoExt.LastIndexOf('/');
 			if (dot > slash) nameNoExt.Truncate(dot);
 
-			j = MakeKey(nameNoExt) % NumEntries;
-			NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
-			FirstLumpIndex_NoExt[j] = i;
-
-			j = FileInfo[i].resourceId % NumEntries;
-			NextLumpIndex_ResId[i] = FirstLumpIndex_ResId[j];
-			FirstLumpIndex_ResId[j] = i;
-
+			NoExtNames.Insert(MakeKey(nameNoExt), i);
+			ResIds.Insert(FileInfo[i].resourceId, i);
 		}
 	}
 	FileInfo.ShrinkToFit();
@@ -1353,6 +1365,175 @@ FileData FileSystem::ReadFile (int lump)
 	return FileData(FString(ELumpNum(lump)));
 }
 
+//==========================================================================
+//
+// Prefetch
+//
+// The raw data is read on the calling thread so that the owning archive's
+// reader is never shared. Only the decompression runs on the worker pool,
+// and the results are moved into the lump cache by FPrefetchHandle::Wait.
+//
+//==========================================================================
+
+struct FPrefetchBatch
+{
+	struct Entry
+	{
+		FResourceLump *Lump;
+		FCompressedBuffer Source;
+		char *Data;
+		bool Cached;
+	};
+
+	TArray<Entry> Entries;
+	int Pending = 0;
+	bool Published = false;
+	std::mutex Mutex;
+	std::condition_variable Done;
+};
+
+static std::unique_ptr<ctpl::thread_pool> PrefetchPool;
+
+static void DecodePrefetchEntry(FPrefetchBatch *batch, unsigned index)
+{
+	auto &entry = batch->Entries[index];
+	char *data = new char[entry.Source.mSize];
+	bool ok;
+	try
+	{
+		ok = entry.Source.Decompress(data, true);
+	}
+	catch (...)
+	{
+		ok = false;
+	}
+	if (!ok)
+	{
+		// Leave it to the regular cache path, which reports the error on the main thread.
+		delete[] data;
+		data = nullptr;
+	}
+	entry.Source.Clean();
+
+	std::lock_guard<std::mutex> lock(batch->Mutex);
+	entry.Data = data;
+	if (--batch->Pending == 0) batch->Done.notify_all();
+}
+
+FPrefetchHandle FileSystem::Prefetch(const int *lumps, int count)
+{
+	FPrefetchHandle handle;
+	handle.Batch = new FPrefetchBatch;
+	auto batch = handle.Batch;
+
+	TMap<int, bool> seen;
+	TMap<FResourceFile *, TArray<FResourceLump *>> archivelumps;
+	for (int i = 0; i < count; i++)
+	{
+		int lump = lumps[i];
+		if ((unsigned)lump >= FileInfo.Size() || seen.CheckKey(lump)) continue;
+		seen.Insert(lump, true);
+
+		auto rl = FileInfo[lump].lump;
+		if (rl->Cache != nullptr || rl->LumpSize <= 0) continue;
+		if (!rl->CanDecodeAsync())
+		{
+			if (rl->Flags & LUMPF_COMPRESSED)
+			{
+				auto list = archivelumps.CheckKey(rl->Owner);
+				if (list == nullptr) list = &archivelumps.Insert(rl->Owner, {});
+				list->Push(rl);
+			}
+			continue;
+		}
+
+		auto &entry = batch->Entries[batch->Entries.Reserve(1)];
+		entry.Lump = rl;
+		entry.Source = rl->GetRawData();
+		entry.Data = nullptr;
+		entry.Cached = false;
+	}
+
+	if (batch->Entries.Size() == 0)
+	{
+		batch->Published = true;
+	}
+	else
+	{
+		if (PrefetchPool == nullptr)
+		{
+			int numthreads = std::max<int>(std::thread::hardware_concurrency(), 2) - 1;
+			PrefetchPool.reset(new ctpl::thread_pool(numthreads));
+		}
+
+		batch->Pending = batch->Entries.Size();
+		for (unsigned i = 0; i < batch->Entries.Size(); i++)
+		{
+			PrefetchPool->push([=](int) { DecodePrefetchEntry(batch, i); });
+		}
+	}
+
+	// Archives which cannot hand out independent compressed buffers, like solid 7z, do their own batching.
+	decltype(archivelumps)::Iterator it(archivelumps);
+	decltype(archivelumps)::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		pair->Key->PrefetchLumps(pair->Value);
+	}
+	return handle;
+}
+
+void FPrefetchHandle::WaitForWorkers()
+{
+	std::unique_lock<std::mutex> lock(Batch->Mutex);
+	Batch->Done.wait(lock, [=] { return Batch->Pending == 0; });
+}
+
+bool FPrefetchHandle::IsReady()
+{
+	if (Batch == nullptr) return true;
+	std::lock_guard<std::mutex> lock(Batch->Mutex);
+	return Batch->Pending == 0;
+}
+
+void FPrefetchHandle::Wait()
+{
+	if (Batch == nullptr || Batch->Published) return;
+	WaitForWorkers();
+
+	for (auto &entry : Batch->Entries)
+	{
+		if (entry.Data == nullptr) continue;
+		if (entry.Lump->Cache == nullptr)
+		{
+			// The handle owns this reference until it is released.
+			entry.Lump->AdoptCache(entry.Data);
+			entry.Cached = true;
+		}
+		else
+		{
+			// Got cached by someone else in the meantime.
+			delete[] entry.Data;
+		}
+		entry.Data = nullptr;
+	}
+	Batch->Published = true;
+}
+
+void FPrefetchHandle::Release()
+{
+	if (Batch == nullptr) return;
+	WaitForWorkers();
+
+	for (auto &entry : Batch->Entries)
+	{
+		if (entry.Cached) entry.Lump->Unlock();
+		if (entry.Data != nullptr) delete[] entry.Data;
+	}
+	delete Batch;
+	Batch = nullptr;
+}
+
 //==========================================================================
 //
 // OpenFileReader
@@ -1372,7 +1553,7 @@ FileReader FileSystem::OpenFileReader(int lump)
 	auto rl = FileInfo[lump].lump;
 	auto rd = rl->GetReader();
 
-	if (rl->RefCount == 0 && rd != nullptr && !rd->GetBuffer() && !(rl->Flags & LUMPF_COMPRESSED))
+	if (rl->Cache == nullptr && rd != nullptr && !rd->GetBuffer() && !(rl->Flags & LUMPF_COMPRESSED))
 	{
 		FileReader rdr;
 		rdr.OpenFilePart(*rd, rl->GetFileOffset(), rl->LumpSize);
@@ -1391,7 +1572,7 @@ FileReader FileSystem::ReopenFileReader(int lump, bool alwayscache)
 	auto rl = FileInfo[lump].lump;
 	auto rd = rl->GetReader();
 
-	if (rl->RefCount == 0 && rd != nullptr && !rd->GetBuffer() && !alwayscache && !(rl->Flags & LUMPF_COMPRESSED))
+	if (rl->Cache == nullptr && rd != nullptr && !rd->GetBuffer() && !alwayscache && !(rl->Flags & LUMPF_COMPRESSED))
 	{
 		int fileno = fileSystem.GetFileContainer(lump);
 		const char *filename = fileSystem.GetResourceFileFullName(fileno);
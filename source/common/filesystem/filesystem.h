@@ -48,6 +48,30 @@ private:
 	friend class FileSystem;
 };
 
+// Waitable handle for lumps that FileSystem::Prefetch decodes in the background.
+// Decoded lumps stay in the lump cache for as long as the handle is alive.
+struct FPrefetchBatch;
+
+class FPrefetchHandle
+{
+	friend class FileSystem;
+	FPrefetchBatch *Batch = nullptr;
+
+	void WaitForWorkers();
+
+public:
+	FPrefetchHandle() = default;
+	FPrefetchHandle(FPrefetchHandle &&other) { Batch = other.Batch; other.Batch = nullptr; }
+	FPrefetchHandle &operator=(FPrefetchHandle &&other) { Release(); Batch = other.Batch; other.Batch = nullptr; return *this; }
+	FPrefetchHandle(const FPrefetchHandle &) = delete;
+	FPrefetchHandle &operator=(const FPrefetchHandle &) = delete;
+	~FPrefetchHandle() { Release(); }
+
+	bool IsReady();
+	void Wait();	// blocks until all lumps are decoded and moves them into the lump cache
+	void Release();	// drops the cache references held by the handle
+};
+
 struct FolderEntry
 {
 	const char *name;
@@ -140,6 +164,9 @@ public:
 		return GetFileData(lump, padding);
 	}
 
+	FPrefetchHandle Prefetch(const int *lumps, int count);	// decompresses lumps into the lump cache on worker threads.
+	FPrefetchHandle Prefetch(const TArray<int> &lumps) { return Prefetch(lumps.Data(), lumps.Size()); }
+
 	FileReader OpenFileReader(int lump);		// opens a reader that redirects to the containing file's one.
 	FileReader ReopenFileReader(int lump, bool alwayscache = false);		// opens an independent reader.
 	FileReader OpenFileReader(const char* name);
@@ -196,18 +223,30 @@ protected:
 	TArray<FResourceFile *> Files;
 	TArray<LumpRecord> FileInfo;
 
-	TArray<uint32_t> Hashes;	// one allocation for all hash lists.
-	uint32_t *FirstLumpIndex;	// [RH] Hashing stuff moved out of lumpinfo structure
-	uint32_t *NextLumpIndex;
-
-	uint32_t *FirstLumpIndex_FullName;	// The same information for fully qualified paths from .zips
-	uint32_t *NextLumpIndex_FullName;
-
-	uint32_t *FirstLumpIndex_NoExt;	// The same information for fully qualified paths from .zips
-	uint32_t *NextLumpIndex_NoExt;
-
-	uint32_t* FirstLumpIndex_ResId;	// The same information for fully qualified paths from .zips
-	uint32_t* NextLumpIndex_ResId;
+	// Open-addressed lookup tables that store each lump's full name hash next to its index,
+	// so that names only get compared on a hash match.
+	struct LumpHashTable
+	{
+		struct Entry
+		{
+			uint32_t Hash;
+			uint32_t Index;
+		};
+
+		TArray<Entry> Slots;
+		int Shift;
+
+		LumpHashTable() { Init(0); }
+		void Init(unsigned count);
+		void Insert(uint32_t hash, uint32_t index);
+		unsigned Home(uint32_t hash) const { return (hash * 0x9E3779B9u) >> Shift; }
+		unsigned Next(unsigned slot) const { return (slot + 1) & (Slots.Size() - 1); }
+	};
+
+	LumpHashTable ShortNames;
+	LumpHashTable FullNames;
+	LumpHashTable NoExtNames;
+	LumpHashTable ResIds;
 
 	uint32_t NumEntries = 0;					// Not necessarily the same as FileInfo.Size()
 	uint32_t NumWads;
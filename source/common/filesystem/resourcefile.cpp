@@ -38,6 +38,9 @@
 #include "resourcefile.h"
 #include "cmdlib.h"
 #include "md5.h"
+#include "m_argv.h"
+#include "printf.h"
+#include "i_specialpaths.h"
 
 
 //==========================================================================
@@ -75,8 +78,7 @@ FResourceLump::~FResourceLump()
 {
 	if (Cache != NULL && RefCount >= 0)
 	{
-		delete [] Cache;
-		Cache = NULL;
+		CacheFree();
 	}
 	Owner = NULL;
 }
@@ -179,6 +181,69 @@ FileReader FResourceLump::NewReader()
 	return FileReader(new FLumpReader(this));
 }
 
+//==========================================================================
+//
+// Lump cache
+//
+// Lumps whose reference count drops to 0 keep their buffer in an LRU list,
+// so that reloading them is free until the byte budget forces them out.
+//
+//==========================================================================
+
+static struct
+{
+	FResourceLump *Newest = nullptr;
+	FResourceLump *Oldest = nullptr;
+	FLumpCacheStats Stats = { 0, 0, 0, 0, 0, 64 * 1024 * 1024 };
+} LumpCache;
+
+void FResourceLump::CacheLink()
+{
+	CachePrev = nullptr;
+	CacheNext = LumpCache.Newest;
+	if (CacheNext) CacheNext->CachePrev = this;
+	else LumpCache.Oldest = this;
+	LumpCache.Newest = this;
+	CacheUnused = true;
+	LumpCache.Stats.UnusedBytes += LumpSize;
+}
+
+void FResourceLump::CacheUnlink()
+{
+	if (CachePrev) CachePrev->CacheNext = CacheNext;
+	else LumpCache.Newest = CacheNext;
+	if (CacheNext) CacheNext->CachePrev = CachePrev;
+	else LumpCache.Oldest = CachePrev;
+	CachePrev = CacheNext = nullptr;
+	CacheUnused = false;
+	LumpCache.Stats.UnusedBytes -= LumpSize;
+}
+
+void FResourceLump::CacheFree()
+{
+	if (CacheUnused) CacheUnlink();
+	if (CacheOwned) LumpCache.Stats.ResidentBytes -= LumpSize;
+	CacheOwned = false;
+	delete [] Cache;
+	Cache = NULL;
+	RefCount = 0;
+}
+
+void LumpCache_SetBudget(size_t bytes)
+{
+	LumpCache.Stats.Budget = bytes;
+	while (LumpCache.Stats.UnusedBytes > LumpCache.Stats.Budget)
+	{
+		LumpCache.Oldest->CacheFree();
+		LumpCache.Stats.Evictions++;
+	}
+}
+
+FLumpCacheStats LumpCache_GetStats()
+{
+	return LumpCache.Stats;
+}
+
 //==========================================================================
 //
 // Caches a lump's content and increases the reference counter
@@ -190,17 +255,40 @@ void *FResourceLump::Lock()
 	if (Cache != NULL)
 	{
 		if (RefCount > 0) RefCount++;
+		else if (CacheUnused)
+		{
+			CacheUnlink();
+			RefCount = 1;
+		}
+		LumpCache.Stats.Hits++;
 	}
 	else if (LumpSize > 0)
 	{
+		LumpCache.Stats.Misses++;
 		FillCache();
+		// Only buffers owned by the lump count, not pointers into memory backed files.
+		if (Cache != NULL && RefCount > 0)
+		{
+			CacheOwned = true;
+			LumpCache.Stats.ResidentBytes += LumpSize;
+		}
 	}
 	return Cache;
 }
 
+void FResourceLump::AdoptCache(char *data)
+{
+	assert(Cache == NULL);
+	Cache = data;
+	RefCount = 1;
+	CacheOwned = true;
+	LumpCache.Stats.ResidentBytes += LumpSize;
+}
+
 //==========================================================================
 //
-// Decrements reference counter and frees lump if counter reaches 0
+// Decrements reference counter and releases the lump to the LRU cache
+// if the counter reaches 0
 //
 //==========================================================================
 
@@ -210,8 +298,15 @@ int FResourceLump::Unlock()
 	{
 		if (--RefCount == 0)
 		{
-			delete [] Cache;
-			Cache = NULL;
+			if ((size_t)LumpSize > LumpCache.Stats.Budget)
+			{
+				CacheFree();
+			}
+			else
+			{
+				CacheLink();
+				LumpCache_SetBudget(LumpCache.Stats.Budget);
+			}
 		}
 	}
 	return RefCount;
@@ -675,4 +770,253 @@ int FExternalLump::FillCache()
 }
 
 
+//==========================================================================
+//
+// Archive directory cache
+//
+//==========================================================================
+
+static const char DirCacheMagic[4] = { 'Z', 'D', 'D', 'C' };
+static const uint32_t DirCacheVersion = 1;
+
+static TMap<FString, FCachedDirectory> DirCache;
+static bool DirCacheLoaded;
+static bool DirCacheChanged;
+
+static bool DirCacheEnabled()
+{
+	return Args == nullptr || !Args->CheckParm("-nodircache");
+}
+
+static FString DirCacheName(bool create)
+{
+	FString path = M_GetCachePath(create);
+	if (create) CreatePath(path);
+	path << "/archivedirs.zddc";
+	return path;
+}
+
+static FString DirCacheFilterKey(LumpFilterInfo *filter)
+{
+	FString key;
+	if (filter == nullptr) return key;
+	for (auto &str : filter->gameTypeFilter) key << str << ';';
+	key << '|' << filter->dotFilter << '|';
+	for (auto &str : filter->reservedFolders) key << str << ';';
+	key << '|';
+	for (auto &str : filter->requiredPrefixes) key << str << ';';
+	key << '|';
+	for (auto &str : filter->embeddings) key << str << ';';
+	return key;
+}
+
+//==========================================================================
+//
+// The cache file is little endian. Every read is bounds checked and the
+// whole file must be consumed, so a truncated or damaged file is ignored
+// as a whole instead of restoring archives with missing lumps.
+//
+//==========================================================================
+
+struct FDirCacheReader
+{
+	const uint8_t *p, *end;
+	bool ok = true;
+
+	bool Need(size_t len)
+	{
+		if (ok && (size_t)(end - p) < len) ok = false;
+		return ok;
+	}
+
+	uint64_t Get(int bytes)
+	{
+		uint64_t v = 0;
+		if (!Need(bytes)) return 0;
+		for (int i = 0; i < bytes; i++) v |= uint64_t(p[i]) << (i * 8);
+		p += bytes;
+		return v;
+	}
+
+	FString GetString()
+	{
+		uint32_t len = (uint32_t)Get(4);
+		if (len > 0x10000) ok = false;
+		if (!Need(len)) return FString();
+		FString str((const char *)p, len);
+		p += len;
+		return str;
+	}
+};
+
+static void DirCache_Load()
+{
+	DirCacheLoaded = true;
+
+	FileReader fr;
+	if (!fr.OpenFile(DirCacheName(false)))
+		return;
+
+	auto buffer = fr.Read();
+	if (buffer.Size() < 12 || memcmp(buffer.Data(), DirCacheMagic, 4) != 0)
+		return;
+
+	FDirCacheReader rd = { buffer.Data() + 4, buffer.Data() + buffer.Size() };
+	if (rd.Get(4) != DirCacheVersion)
+		return;
+
+	TMap<FString, FCachedDirectory> cache;
+	uint32_t count = (uint32_t)rd.Get(4);
+	for (uint32_t i = 0; i < count && rd.ok; i++)
+	{
+		FString filename = rd.GetString();
+		FCachedDirectory &dir = cache[filename];
+		dir.FileSize = rd.Get(8);
+		dir.FileTime = (int64_t)rd.Get(8);
+		dir.FilterKey = rd.GetString();
+		dir.Hash = rd.GetString();
+		dir.Used = false;
+
+		uint32_t numlumps = (uint32_t)rd.Get(4);
+		if (numlumps > 0x1000000) return;
+		dir.Lumps.Resize(numlumps);
+		for (auto &lump : dir.Lumps)
+		{
+			lump.Name = rd.GetString();
+			lump.LumpSize = (int)rd.Get(4);
+			lump.CompressedSize = (int)rd.Get(4);
+			lump.Position = (int)rd.Get(4);
+			lump.CRC32 = (uint32_t)rd.Get(4);
+			lump.GPFlags = (uint16_t)rd.Get(2);
+			lump.Method = (uint8_t)rd.Get(1);
+			lump.Flags = (uint8_t)rd.Get(1);
+			if (!rd.ok) return;
+		}
+	}
+	if (!rd.ok || rd.p != rd.end)
+		return;
+
+	DirCache.TransferFrom(cache);
+}
+
+static bool DirCacheFileInfo(const char *filename, FileReader &reader, uint64_t &size, int64_t &time)
+{
+	size_t filesize;
+	time_t filetime;
+	// Only real files have a modification time to validate against.
+	if (!GetFileInfo(filename, &filesize, &filetime) || filesize != (size_t)reader.GetLength()) return false;
+	size = filesize;
+	time = filetime;
+	return true;
+}
+
+FCachedDirectory *DirCache_Find(const char *filename, FileReader &reader, LumpFilterInfo *filter)
+{
+	if (!DirCacheEnabled()) return nullptr;
+	if (!DirCacheLoaded) DirCache_Load();
+
+	uint64_t size;
+	int64_t time;
+	if (!DirCacheFileInfo(filename, reader, size, time)) return nullptr;
+
+	auto dir = DirCache.CheckKey(filename);
+	if (dir == nullptr || dir->FileSize != size || dir->FileTime != time || dir->FilterKey.Compare(DirCacheFilterKey(filter)) != 0)
+		return nullptr;
+	dir->Used = true;
+	return dir;
+}
+
+FCachedDirectory *DirCache_Add(const char *filename, FileReader &reader, LumpFilterInfo *filter)
+{
+	if (!DirCacheEnabled()) return nullptr;
+	if (!DirCacheLoaded) DirCache_Load();
+
+	uint64_t size;
+	int64_t time;
+	if (!DirCacheFileInfo(filename, reader, size, time)) return nullptr;
+
+	FCachedDirectory &dir = DirCache[filename];
+	dir.FileSize = size;
+	dir.FileTime = time;
+	dir.FilterKey = DirCacheFilterKey(filter);
+	dir.Hash = "";
+	dir.Lumps.Clear();
+	dir.Used = true;
+	DirCacheChanged = true;
+	return &dir;
+}
+
+void DirCache_Save()
+{
+	if (!DirCacheChanged) return;
+	DirCacheChanged = false;
+
+	// Entries for archives that no longer exist are dropped.
+	TArray<FString> stale;
+	decltype(DirCache)::Iterator it(DirCache);
+	decltype(DirCache)::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		if (!pair->Value.Used && !FileExists(pair->Key)) stale.Push(pair->Key);
+	}
+	for (auto &key : stale) DirCache.Remove(key);
+
+	TArray<uint8_t> out;
+	auto put = [&](uint64_t v, int bytes)
+	{
+		for (int i = 0; i < bytes; i++) out.Push(uint8_t(v >> (i * 8)));
+	};
+	auto putbytes = [&](const void *data, size_t len)
+	{
+		unsigned pos = out.Reserve((unsigned)len);
+		if (len > 0) memcpy(&out[pos], data, len);
+	};
+	auto putstring = [&](const FString &str)
+	{
+		put(str.Len(), 4);
+		putbytes(str.GetChars(), str.Len());
+	};
+
+	putbytes(DirCacheMagic, 4);
+	put(DirCacheVersion, 4);
+	put(DirCache.CountUsed(), 4);
 
+	decltype(DirCache)::Iterator it2(DirCache);
+	while (it2.NextPair(pair))
+	{
+		auto &dir = pair->Value;
+		putstring(pair->Key);
+		put(dir.FileSize, 8);
+		put(uint64_t(dir.FileTime), 8);
+		putstring(dir.FilterKey);
+		putstring(dir.Hash);
+
+		put(dir.Lumps.Size(), 4);
+		for (auto &lump : dir.Lumps)
+		{
+			putstring(lump.Name);
+			put(uint32_t(lump.LumpSize), 4);
+			put(uint32_t(lump.CompressedSize), 4);
+			put(uint32_t(lump.Position), 4);
+			put(lump.CRC32, 4);
+			put(lump.GPFlags, 2);
+			put(lump.Method, 1);
+			put(lump.Flags, 1);
+		}
+	}
+
+	// Write to a temporary file first so that an interrupted save cannot leave a damaged cache behind.
+	FString filename = DirCacheName(true);
+	FString tempname = filename + ".tmp";
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(tempname));
+	if (!fw) return;
+	bool ok = fw->Write(out.Data(), out.Size()) == out.Size();
+	fw.reset();
+	if (!ok)
+	{
+		remove(tempname);
+		return;
+	}
+	remove(filename);
+	if (rename(tempname, filename) != 0) remove(tempname);
+}
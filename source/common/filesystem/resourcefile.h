@@ -71,7 +71,7 @@ struct FCompressedBuffer
 	unsigned mCRC32;
 	char *mBuffer;
 
-	bool Decompress(char *destbuffer);
+	bool Decompress(char *destbuffer, bool quiet = false);	// quiet decompression is safe to run on worker threads.
 	void Clean()
 	{
 		mSize = mCompressedSize = 0;
@@ -97,12 +97,22 @@ public:
 	char *			Cache;
 	FResourceFile *	Owner;
 
+private:
+	// Links in the cache's LRU list while the lump is cached but no longer locked.
+	FResourceLump *	CachePrev;
+	FResourceLump *	CacheNext;
+	bool			CacheUnused;
+	bool			CacheOwned;	// counted in the cache's resident bytes
+
+public:
 	FResourceLump()
 	{
 		Cache = NULL;
 		Owner = NULL;
 		Flags = 0;
 		RefCount = 0;
+		CachePrev = CacheNext = NULL;
+		CacheUnused = CacheOwned = false;
 	}
 
 	virtual ~FResourceLump();
@@ -114,9 +124,11 @@ public:
 	void LumpNameSetup(FString iname);
 	void CheckEmbedded(LumpFilterInfo* lfi);
 	virtual FCompressedBuffer GetRawData();
+	virtual bool CanDecodeAsync() const { return false; }	// true if decompressing GetRawData's output is the expensive part of caching this lump.
 
 	void *Lock(); // validates the cache and increases the refcount.
-	int Unlock(); // decreases the refcount and frees the buffer
+	int Unlock(); // decreases the refcount and hands the buffer to the LRU cache
+	void AdoptCache(char *data); // takes ownership of an externally filled buffer and locks it once.
 
 	unsigned Size() const{ return LumpSize; }
 	int LockCount() const { return RefCount; }
@@ -125,8 +137,28 @@ public:
 protected:
 	virtual int FillCache() { return -1; }
 
+private:
+	void CacheLink();
+	void CacheUnlink();
+	void CacheFree();
+
+	friend void LumpCache_SetBudget(size_t bytes);
 };
 
+// Unreferenced lump buffers are kept around until the budget is exceeded, then the least recently used ones are freed.
+struct FLumpCacheStats
+{
+	uint64_t Hits;
+	uint64_t Misses;
+	uint64_t Evictions;
+	size_t ResidentBytes;	// all buffers owned by lump caches
+	size_t UnusedBytes;		// the evictable part of the above
+	size_t Budget;
+};
+
+void LumpCache_SetBudget(size_t bytes);
+FLumpCacheStats LumpCache_GetStats();
+
 class FResourceFile
 {
 public:
@@ -166,6 +198,7 @@ public:
 
 
 	virtual FResourceLump *GetLump(int no) = 0;
+	virtual void PrefetchLumps(const TArray<FResourceLump *> &lumps) {}	// for archives that can decode several lumps more efficiently at once.
 	FResourceLump *FindLump(const char *name);
 };
 
@@ -222,4 +255,40 @@ struct FMemoryLump : public FResourceLump
 
 
 
+//==========================================================================
+//
+// Persistent archive directory cache
+//
+// Stores the final lump table of an archive, keyed by its path, size,
+// modification time and lump filter, so that unchanged archives can be
+// set up without parsing their directory.
+//
+//==========================================================================
+
+struct FCachedLumpInfo
+{
+	FString Name;
+	int LumpSize;
+	int CompressedSize;
+	int Position;
+	uint32_t CRC32;
+	uint16_t GPFlags;
+	uint8_t Method;
+	uint8_t Flags;
+};
+
+struct FCachedDirectory
+{
+	uint64_t FileSize;
+	int64_t FileTime;
+	FString FilterKey;
+	FString Hash;
+	TArray<FCachedLumpInfo> Lumps;
+	bool Used;
+};
+
+FCachedDirectory *DirCache_Find(const char *filename, FileReader &reader, LumpFilterInfo *filter);
+FCachedDirectory *DirCache_Add(const char *filename, FileReader &reader, LumpFilterInfo *filter);
+void DirCache_Save();
+
 #endif
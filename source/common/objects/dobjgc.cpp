@@ -62,6 +62,8 @@
 #include "menu.h"
 #include "stats.h"
 #include "printf.h"
+#include "c_cvars.h"
+#include "i_time.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -91,8 +93,40 @@
 #define GCSWEEPCOST		10
 #define GCFINALIZECOST	100
 
+// Number of single steps between checks of the time budget.
+#define GCBUDGETCHECK	32
+
 // TYPES -------------------------------------------------------------------
 
+// Pause times of the collector, for gcstats.
+struct FGCPauseStats
+{
+	enum { NUM_BUCKETS = 10 };
+	static const int BucketLimits[NUM_BUCKETS - 1];	// in microseconds
+
+	int Counts[NUM_BUCKETS];
+	int NumPauses;
+	uint64_t Total;		// in nanoseconds
+	uint64_t Longest;
+
+	void Clear()
+	{
+		memset(this, 0, sizeof(*this));
+	}
+
+	void Add(uint64_t ns)
+	{
+		int bucket = 0;
+		while (bucket < NUM_BUCKETS - 1 && ns >= uint64_t(BucketLimits[bucket]) * 1000) bucket++;
+		Counts[bucket]++;
+		NumPauses++;
+		Total += ns;
+		if (ns > Longest) Longest = ns;
+	}
+};
+
+const int FGCPauseStats::BucketLimits[] = { 50, 100, 250, 500, 1000, 2000, 5000, 10000, 50000 };
+
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
 
 // PUBLIC FUNCTION PROTOTYPES ----------------------------------------------
@@ -103,6 +137,11 @@
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
+// Maximum time incremental collection steps may take per frame, in microseconds. 0 means no limit.
+// The limit is lifted while memory use exceeds twice the live size estimate, so that the collector
+// cannot fall behind the allocations indefinitely.
+CVAR(Int, gc_framebudget, 1000, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
 namespace GC
 {
 size_t AllocBytes;
@@ -122,6 +161,11 @@ bool FinalGC;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
+static FGCPauseStats StepStats, FrameStats, FullStats;
+static uint64_t FrameStart;
+static uint64_t FrameTime;		// time spent in Step during the current frame, in nanoseconds
+static int BudgetLimitedSteps;
+
 // CODE --------------------------------------------------------------------
 
 //==========================================================================
@@ -373,6 +417,22 @@ static size_t SingleStep()
 
 void Step()
 {
+	uint64_t start = I_nsTime();
+	if (start - FrameStart > 100000000)	// 100 ms
+	{ // Loops that do not go through the main loop, like loading screens, do not begin new frames.
+		BeginFrame();
+	}
+	uint64_t budget = ~(uint64_t)0;
+	if (gc_framebudget > 0 && AllocBytes / 2 <= Estimate)
+	{
+		budget = uint64_t(gc_framebudget) * 1000;
+		if (FrameTime >= budget)
+		{ // Try again next frame.
+			return;
+		}
+		budget -= FrameTime;
+	}
+
 	size_t lim = (GCSTEPSIZE/100) * StepMul;
 	size_t olim;
 	if (lim == 0)
@@ -380,10 +440,20 @@ void Step()
 		lim = (~(size_t)0) / 2;		// no limit
 	}
 	Dept += AllocBytes - Threshold;
+	int checkcount = GCBUDGETCHECK;
 	do
 	{
 		olim = lim;
 		lim -= SingleStep();
+		if (--checkcount == 0)
+		{
+			checkcount = GCBUDGETCHECK;
+			if (I_nsTime() - start >= budget)
+			{
+				BudgetLimitedSteps++;
+				break;
+			}
+		}
 	} while (olim > lim && State != GCS_Pause);
 	if (State != GCS_Pause)
 	{
@@ -403,6 +473,29 @@ void Step()
 		SetThreshold();
 	}
 	StepCount++;
+
+	uint64_t time = I_nsTime() - start;
+	StepStats.Add(time);
+	FrameTime += time;
+}
+
+//==========================================================================
+//
+// BeginFrame
+//
+// Resets the time budget. Also records how long the collector paused the
+// previous frame in total.
+//
+//==========================================================================
+
+void BeginFrame()
+{
+	if (FrameTime > 0)
+	{
+		FrameStats.Add(FrameTime);
+	}
+	FrameTime = 0;
+	FrameStart = I_nsTime();
 }
 
 //==========================================================================
@@ -415,6 +508,7 @@ void Step()
 
 void FullGC()
 {
+	uint64_t start = I_nsTime();
 	if (State <= GCS_Propagate)
 	{
 		// Reset sweep mark to sweep all elements (returning them to white)
@@ -434,6 +528,7 @@ void FullGC()
 		SingleStep();
 	}
 	SetThreshold();
+	FullStats.Add(I_nsTime() - start);
 }
 
 //==========================================================================
@@ -640,3 +735,47 @@ CCMD(gc)
 	}
 }
 
+//==========================================================================
+//
+// CCMD gcstats
+//
+// Prints histograms of the pauses caused by the collector.
+//
+//==========================================================================
+
+static void PrintPauseStats(const char *name, const FGCPauseStats &stats)
+{
+	Printf("%s: %d, total %.2f ms, average %.1f us, longest %.1f us\n", name, stats.NumPauses, stats.Total / 1e6,
+		stats.NumPauses > 0 ? stats.Total / 1e3 / stats.NumPauses : 0., stats.Longest / 1e3);
+	if (stats.NumPauses == 0) return;
+
+	int maxcount = 1;
+	for (auto count : stats.Counts) maxcount = MAX(maxcount, count);
+	for (int i = 0; i < FGCPauseStats::NUM_BUCKETS; i++)
+	{
+		FString range;
+		if (i == 0) range.Format("< %d", FGCPauseStats::BucketLimits[0]);
+		else if (i == FGCPauseStats::NUM_BUCKETS - 1) range.Format(">= %d", FGCPauseStats::BucketLimits[i - 1]);
+		else range.Format("%d - %d", FGCPauseStats::BucketLimits[i - 1], FGCPauseStats::BucketLimits[i]);
+
+		FString bar;
+		for (int j = stats.Counts[i] * 40 / maxcount; j > 0; j--) bar += '#';
+		Printf("  %14s us %8d %s\n", range.GetChars(), stats.Counts[i], bar.GetChars());
+	}
+}
+
+CCMD(gcstats)
+{
+	if (argv.argc() > 1 && stricmp(argv[1], "reset") == 0)
+	{
+		GC::StepStats.Clear();
+		GC::FrameStats.Clear();
+		GC::FullStats.Clear();
+		GC::BudgetLimitedSteps = 0;
+		return;
+	}
+	PrintPauseStats("Incremental steps", GC::StepStats);
+	PrintPauseStats("Frames with collection work", GC::FrameStats);
+	PrintPauseStats("Full collections", GC::FullStats);
+	Printf("%d steps were cut short by gc_framebudget (%d us)\n", GC::BudgetLimitedSteps, *gc_framebudget);
+}
@@ -85,6 +85,9 @@ namespace GC
 	// Does a complete collection.
 	void FullGC();
 
+	// Starts a new frame for the collector's time budget.
+	void BeginFrame();
+
 	// Handles the grunt work for a write barrier.
 	void Barrier(DObject *pointing, DObject *pointed);
 
@@ -17,6 +17,7 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 #endif
 
 	using namespace asmjit;
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
 	StringLogger logger;
 	try
 	{
@@ -37,6 +38,28 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 	}
 }
 
+// Variant for the background compiler: does not print anything and returns the error message instead.
+JitFuncPtr JitCompileQuiet(VMScriptFunction *sfunc, FString &error)
+{
+	using namespace asmjit;
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
+	try
+	{
+		ThrowingErrorHandler errorHandler;
+		CodeHolder code;
+		code.init(GetHostCodeInfo());
+		code.setErrorHandler(&errorHandler);
+
+		JitCompiler compiler(&code, sfunc);
+		return reinterpret_cast<JitFuncPtr>(AddJitFunction(&code, &compiler));
+	}
+	catch (const std::exception &e)
+	{
+		error = e.what();
+		return nullptr;
+	}
+}
+
 void JitDumpLog(FILE *file, VMScriptFunction *sfunc)
 {
 	using namespace asmjit;
@@ -6,3 +6,14 @@
 JitFuncPtr JitCompile(VMScriptFunction *func);
 void JitDumpLog(FILE *file, VMScriptFunction *func);
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames);
+JitFuncPtr JitCompileQuiet(VMScriptFunction *func, FString &error);
+
+// jit_background.cpp
+void JitBackgroundStart(const TArray<VMScriptFunction*> &functions);
+void JitBackgroundApply();
+void JitBackgroundStop();
+
+// For code generators outside the script VM that want to share the JIT's memory and debug info.
+namespace asmjit { class CodeHolder; class CCFunc; class CodeInfo; }
+asmjit::CodeInfo GetHostCodeInfo();
+void *AddJitFunction(asmjit::CodeHolder* code, asmjit::CCFunc *func, const FString &name, const FString &filename);
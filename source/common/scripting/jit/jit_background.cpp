@@ -0,0 +1,95 @@
+
+#include <thread>
+#include <atomic>
+#include "jit.h"
+#include "jitintern.h"
+#include "printf.h"
+
+// Compiles a list of script functions on a worker thread.
+//
+// The worker never touches the functions' ScriptCall pointers. It only collects
+// the results, which get installed on the main thread by JitBackgroundApply.
+// Until then the functions keep running through their current ScriptCall.
+
+struct JitBackgroundResult
+{
+	VMScriptFunction *func;
+	JitFuncPtr code;
+	FString error;
+};
+
+static std::thread JitThread;
+static std::vector<VMScriptFunction*> JitQueue;
+static std::vector<JitBackgroundResult> JitResults;
+static std::mutex JitResultMutex;
+static std::atomic<bool> JitResultsReady;
+static std::atomic<bool> JitStopRequested;
+
+static void JitBackgroundThread()
+{
+	for (auto func : JitQueue)
+	{
+		if (JitStopRequested)
+			break;
+
+		JitBackgroundResult result = { func, nullptr };
+		result.code = JitCompileQuiet(func, result.error);
+
+		std::lock_guard<std::mutex> lock(JitResultMutex);
+		JitResults.push_back(std::move(result));
+		JitResultsReady = true;
+	}
+}
+
+void JitBackgroundStart(const TArray<VMScriptFunction*> &functions)
+{
+	JitBackgroundStop();
+	if (functions.Size() == 0)
+		return;
+
+	// This initializes a function level static, so do it before the worker gets to it.
+	GetHostCodeInfo();
+
+	JitQueue.assign(functions.begin(), functions.end());
+	JitStopRequested = false;
+	JitThread = std::thread(JitBackgroundThread);
+}
+
+void JitBackgroundApply()
+{
+	if (!JitResultsReady)
+		return;
+
+	std::vector<JitBackgroundResult> results;
+	{
+		std::lock_guard<std::mutex> lock(JitResultMutex);
+		results.swap(JitResults);
+		JitResultsReady = false;
+	}
+
+	for (auto &result : results)
+	{
+		auto func = result.func;
+		if (func->ScriptCall != &VMScriptFunction::BackgroundJitCall)
+			continue;
+
+		if (result.error.IsNotEmpty())
+			Printf("%s: Unexpected JIT error: %s\n", func->PrintableName.GetChars(), result.error.GetChars());
+
+		func->ScriptCall = result.code ? result.code : VMExec;
+	}
+}
+
+void JitBackgroundStop()
+{
+	if (JitThread.joinable())
+	{
+		JitStopRequested = true;
+		JitThread.join();
+	}
+	JitQueue.clear();
+
+	std::lock_guard<std::mutex> lock(JitResultMutex);
+	JitResults.clear();
+	JitResultsReady = false;
+}
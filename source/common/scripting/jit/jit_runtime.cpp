@@ -28,6 +28,8 @@ static TArray<uint8_t*> JitFrames;
 static size_t JitBlockPos = 0;
 static size_t JitBlockSize = 0;
 
+std::recursive_mutex JitMutex;
+
 asmjit::CodeInfo GetHostCodeInfo()
 {
 	static bool firstCall = true;
@@ -252,12 +254,10 @@ static TArray<uint16_t> CreateUnwindInfoWindows(asmjit::CCFunc *func)
 	return info;
 }
 
-void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
+void *AddJitFunction(asmjit::CodeHolder* code, asmjit::CCFunc *func, const FString &name, const FString &filename, const TArray<JitLineInfo> &lineinfo)
 {
 	using namespace asmjit;
 
-	CCFunc *func = compiler->Codegen();
-
 	size_t codeSize = code->getCodeSize();
 	if (codeSize == 0)
 		return nullptr;
@@ -305,7 +305,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 	if (result == 0)
 		I_Error("RtlAddFunctionTable failed");
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	JitDebugInfo.Push({ name, filename, lineinfo, startaddr, endaddr });
 #endif
 
 	return p;
@@ -648,12 +648,10 @@ static TArray<uint8_t> CreateUnwindInfoUnix(asmjit::CCFunc *func, unsigned int &
 	return stream;
 }
 
-void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
+void *AddJitFunction(asmjit::CodeHolder* code, asmjit::CCFunc *func, const FString &name, const FString &filename, const TArray<JitLineInfo> &lineinfo)
 {
 	using namespace asmjit;
 
-	CCFunc *func = compiler->Codegen();
-
 	size_t codeSize = code->getCodeSize();
 	if (codeSize == 0)
 		return nullptr;
@@ -729,14 +727,34 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 #endif
 	}
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	JitDebugInfo.Push({ name, filename, lineinfo, startaddr, endaddr });
 
 	return p;
 }
 #endif
 
+void *AddJitFunction(asmjit::CodeHolder* code, asmjit::CCFunc *func, const FString &name, const FString &filename)
+{
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
+	return AddJitFunction(code, func, name, filename, TArray<JitLineInfo>());
+}
+
+void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
+{
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
+	asmjit::CCFunc *func = compiler->Codegen();
+	auto sfunc = compiler->GetScriptFunction();
+	// The names get stored in the debug info. Copy the text instead of sharing the strings with the
+	// function, because this may run on the background compiler thread and FString's reference count is not atomic.
+	FString name = sfunc->PrintableName.GetChars();
+	FString filename = sfunc->SourceFileName.GetChars();
+	return AddJitFunction(code, func, name, filename, compiler->LineInfo);
+}
+
 void JitRelease()
 {
+	JitBackgroundStop();
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
 #ifdef _WIN64
 	for (auto p : JitFrames)
 	{
@@ -954,6 +972,7 @@ FString JitGetStackFrameName(NativeSymbolResolver *nativeSymbols, void *pc)
 
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames)
 {
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
 	void *frames[32];
 	int numframes = CaptureStackTrace(32, frames);
 
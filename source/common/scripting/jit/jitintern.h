@@ -12,6 +12,7 @@
 #include <asmjit/x86.h>
 #include <functional>
 #include <vector>
+#include <mutex>
 
 extern cycle_t VMCycles[10];
 extern int VMCalls[10];
@@ -334,4 +335,8 @@ public:
 };
 
 void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler);
+void *AddJitFunction(asmjit::CodeHolder* code, asmjit::CCFunc *func, const FString &name, const FString &filename, const TArray<JitLineInfo> &lineinfo);
 asmjit::CodeInfo GetHostCodeInfo();
+
+// Serializes code generation and access to the JIT's memory and debug info with the background compiler.
+extern std::recursive_mutex JitMutex;
@@ -55,6 +55,8 @@ extern FMemArena ClassDataAllocator;
 #define MAX_TRY_DEPTH	8	// Maximum number of nested TRYs in a single function
 
 void JitRelease();
+void VMStartBackgroundJit();
+void VMShutdownJit();
 
 extern void (*VM_CastSpriteIDToString)(FString* a, unsigned int b);
 
@@ -430,6 +432,8 @@ public:
 	void operator delete[](void *block) {}
 	static void DeleteAll()
 	{
+		// stop the background compiler and save the JIT hot list while the functions still exist
+		VMShutdownJit();
 		for (auto f : AllFunctions)
 		{
 			f->~VMFunction();
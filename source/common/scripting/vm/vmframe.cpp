@@ -43,6 +43,10 @@
 #include "jit.h"
 #include "c_cvars.h"
 #include "version.h"
+#include "files.h"
+#include "cmdlib.h"
+#include "i_specialpaths.h"
+#include "i_time.h"
 
 #ifdef HAVE_VM_JIT
 #ifdef __DragonFly__
@@ -54,10 +58,17 @@ CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
 	Printf("You must restart " GAMENAME " for this change to take effect.\n");
 	Printf("This cvar is currently not saved. You must specify it on the command line.");
 }
+
+// 0: compile each function on its first call
+// 1: compile the functions used in earlier sessions on a background thread after loading the scripts
+// 2: compile all functions on a background thread after loading the scripts
+CVAR(Int, vm_jit_aot, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 #else
 CVAR(Bool, vm_jit, false, CVAR_NOINITCALL|CVAR_NOSET)
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames) { return FString(); }
 void JitRelease() {}
+void VMStartBackgroundJit() {}
+void VMShutdownJit() {}
 #endif
 
 cycle_t VMCycles[10];
@@ -268,7 +279,8 @@ int VMScriptFunction::PCToLine(const VMOP *pc)
 	return -1;
 }
 
-static bool CanJit(VMScriptFunction *func)
+#ifdef HAVE_VM_JIT
+static bool CanJit(VMScriptFunction *func, bool quiet = false)
 {
 	// Asmjit has a 256 register limit. Stay safely away from it as the jit compiler uses a few for temporaries as well.
 	// Any function exceeding the limit will use the VM - a fair punishment to someone for writing a function so bloated ;)
@@ -277,11 +289,132 @@ static bool CanJit(VMScriptFunction *func)
 	if (func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS < maxregs)
 		return true;
 
-	Printf(TEXTCOLOR_ORANGE "%s is using too many registers (%d of max %d)! Function will not use native code.\n", func->PrintableName.GetChars(), func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS, maxregs);
+	if (!quiet) Printf(TEXTCOLOR_ORANGE "%s is using too many registers (%d of max %d)! Function will not use native code.\n", func->PrintableName.GetChars(), func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS, maxregs);
 
 	return false;
 }
 
+//===========================================================================
+//
+// JIT hot list
+//
+// The names of all functions that got called while vm_jit_aot was 1.
+// The next session compiles them in the background right after loading
+// the scripts. The list only grows.
+//
+//===========================================================================
+
+static TMap<FString, bool> JitHotList;
+static bool JitHotListLoaded;
+static bool JitHotListDirty;
+
+static FString JitHotListName(bool create)
+{
+	FString path = M_GetCachePath(create);
+	if (create) CreatePath(path);
+	path += "/jithotlist.txt";
+	return path;
+}
+
+static void LoadJitHotList()
+{
+	if (JitHotListLoaded) return;
+	JitHotListLoaded = true;
+
+	FileReader fr;
+	if (!fr.OpenFile(JitHotListName(false))) return;
+
+	char line[1024];
+	while (fr.Gets(line, sizeof(line)))
+	{
+		FString name = line;
+		name.StripLeftRight();
+		if (name.IsNotEmpty()) JitHotList[name] = true;
+	}
+}
+
+static void SaveJitHotList()
+{
+	if (!JitHotListDirty) return;
+	JitHotListDirty = false;
+
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(JitHotListName(true)));
+	if (!fw) return;
+
+	TMap<FString, bool>::Iterator it(JitHotList);
+	TMap<FString, bool>::Pair* pair;
+	while (it.NextPair(pair))
+	{
+		fw->Printf("%s\n", pair->Key.GetChars());
+	}
+}
+
+static void AddToJitHotList(VMFunction *func)
+{
+	if (vm_jit_aot == 1 && !JitHotList.CheckKey(func->PrintableName))
+	{
+		JitHotList[func->PrintableName] = true;
+		JitHotListDirty = true;
+	}
+}
+
+//===========================================================================
+//
+// Queues the functions selected by vm_jit_aot for the background compiler.
+// They run in the VM until their code is ready.
+//
+//===========================================================================
+
+void VMStartBackgroundJit()
+{
+	JitBackgroundStop();
+	if (!vm_jit || vm_jit_aot <= 0) return;
+	if (vm_jit_aot == 1) LoadJitHotList();
+
+	TArray<VMScriptFunction*> functions;
+	for (auto f : VMFunction::AllFunctions)
+	{
+		if ((f->VarFlags & (VARF_Native | VARF_Abstract)) || f->ScriptCall != &VMScriptFunction::FirstScriptCall) continue;
+
+		auto sfunc = static_cast<VMScriptFunction*>(f);
+		if (sfunc->Code == nullptr || !CanJit(sfunc, true)) continue;
+		if (vm_jit_aot == 1 && !JitHotList.CheckKey(sfunc->PrintableName)) continue;
+
+		sfunc->ScriptCall = &VMScriptFunction::BackgroundJitCall;
+		functions.Push(sfunc);
+	}
+	JitBackgroundStart(functions);
+}
+
+void VMShutdownJit()
+{
+	JitBackgroundStop();
+	for (auto f : VMFunction::AllFunctions)
+	{
+		// anything the background compiler did not finish goes back to the regular path.
+		if (f->ScriptCall == &VMScriptFunction::BackgroundJitCall)
+			f->ScriptCall = &VMScriptFunction::FirstScriptCall;
+	}
+	SaveJitHotList();
+}
+
+//===========================================================================
+//
+// Installed for functions waiting for the background compiler. Picks up
+// the finished code of all functions, so every function switches on the
+// main thread when it gets called next.
+//
+//===========================================================================
+
+int VMScriptFunction::BackgroundJitCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	JitBackgroundApply();
+	if (func->ScriptCall != &VMScriptFunction::BackgroundJitCall)
+		return func->ScriptCall(func, params, numparams, ret, numret);
+	return VMExec(func, params, numparams, ret, numret);
+}
+#endif // HAVE_VM_JIT
+
 int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
 {
 	// [Player701] Check that we aren't trying to call an abstract function.
@@ -292,6 +425,7 @@ int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int num
 		ThrowAbortException(X_OTHER, "attempt to call abstract function %s.", func->PrintableName.GetChars());
 	}
 #ifdef HAVE_VM_JIT
+	if (vm_jit) AddToJitHotList(func);
 	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
 	{
 		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
@@ -330,15 +464,16 @@ int VMNativeFunction::NativeScriptCall(VMFunction *func, VMValue *params, int nu
 // VMFrame :: InitRegS
 //
 // Initialize the string registers of a newly-allocated VMFrame.
+// Nothing gets allocated until a register is assigned a string. PopFrame
+// checks every register but only releases the ones which were.
 //
 //===========================================================================
 
 void VMFrame::InitRegS()
 {
-	FString *regs = GetRegS();
-	for (int i = 0; i < NumRegS; ++i)
+	if (NumRegS != 0)
 	{
-		::new(&regs[i]) FString;
+		FString::ConstructEmpty(GetRegS(), NumRegS);
 	}
 }
 
@@ -404,7 +539,6 @@ VMFrame *VMFrameStack::AllocFrame(VMScriptFunction *func)
 	frame->NumRegS = func->NumRegS;
 	frame->NumRegA = func->NumRegA;
 	frame->MaxParam = func->MaxParam;
-	frame->Func = func;
 	frame->InitRegS();
 	if (func->SpecialInits.Size())
 	{
@@ -424,49 +558,59 @@ VMFrame *VMFrameStack::AllocFrame(VMScriptFunction *func)
 
 VMFrame *VMFrameStack::Alloc(int size)
 {
-	BlockHeader *block;
-	VMFrame *frame, *parent;
-
 	size = (size + 15) & ~15;
-	block = Blocks;
-	if (block != NULL)
+	BlockHeader *block = Blocks;
+	if (block == NULL || ((VM_UBYTE *)block + block->BlockSize) < (block->FreeSpace + size))
 	{
-		parent = block->LastFrame;
+		return AllocInNewBlock(size);
 	}
-	else
+	VMFrame *frame = (VMFrame *)block->FreeSpace;
+	memset(frame, 0, size);
+	frame->ParentFrame = block->LastFrame;
+	block->FreeSpace += size;
+	block->LastFrame = frame;
+	return frame;
+}
+
+//===========================================================================
+//
+// VMFrameStack :: AllocInNewBlock
+//
+// Slow path of Alloc for when the current block is full.
+//
+//===========================================================================
+
+VMFrame *VMFrameStack::AllocInNewBlock(int size)
+{
+	BlockHeader *block;
+	VMFrame *parent = Blocks != NULL ? Blocks->LastFrame : NULL;
+	int blocksize = ((sizeof(BlockHeader) + 15) & ~15) + size;
+	BlockHeader **blockp;
+	if (blocksize < BLOCK_SIZE)
 	{
-		parent = NULL;
+		blocksize = BLOCK_SIZE;
 	}
-	if (block == NULL || ((VM_UBYTE *)block + block->BlockSize) < (block->FreeSpace + size))
-	{ // Not enough space. Allocate a new block.
-		int blocksize = ((sizeof(BlockHeader) + 15) & ~15) + size;
-		BlockHeader **blockp;
-		if (blocksize < BLOCK_SIZE)
-		{
-			blocksize = BLOCK_SIZE;
-		}
-		for (blockp = &UnusedBlocks, block = *blockp; block != NULL; block = block->NextBlock)
-		{
-			if (block->BlockSize >= blocksize)
-			{
-				break;
-			}
-		}
-		if (block != NULL)
-		{
-			*blockp = block->NextBlock;
-		}
-		else
+	for (blockp = &UnusedBlocks, block = *blockp; block != NULL; blockp = &block->NextBlock, block = *blockp)
+	{
+		if (block->BlockSize >= blocksize)
 		{
-			block = (BlockHeader *)new VM_UBYTE[blocksize];
-			block->BlockSize = blocksize;
+			break;
 		}
-		block->InitFreeSpace();
-		block->LastFrame = NULL;
-		block->NextBlock = Blocks;
-		Blocks = block;
 	}
-	frame = (VMFrame *)block->FreeSpace;
+	if (block != NULL)
+	{
+		*blockp = block->NextBlock;
+	}
+	else
+	{
+		block = (BlockHeader *)new VM_UBYTE[blocksize];
+		block->BlockSize = blocksize;
+	}
+	block->InitFreeSpace();
+	block->NextBlock = Blocks;
+	Blocks = block;
+
+	VMFrame *frame = (VMFrame *)block->FreeSpace;
 	memset(frame, 0, size);
 	frame->ParentFrame = parent;
 	block->FreeSpace += size;
@@ -501,10 +645,9 @@ VMFrame *VMFrameStack::PopFrame()
 		Func->DestroyExtra(frame->GetExtra());
 	}
 	// Free any string registers this frame had.
-	FString *regs = frame->GetRegS();
-	for (int i = frame->NumRegS; i != 0; --i)
+	if (frame->NumRegS != 0)
 	{
-		(regs++)->~FString();
+		FString::DestroyArray(frame->GetRegS(), frame->NumRegS);
 	}
 	VMFrame *parent = frame->ParentFrame;
 	if (parent == NULL)
@@ -784,3 +927,63 @@ CCMD(vmengine)
 	Printf("Usage: vmengine <default|checked|unchecked>\n");
 }
 
+//-----------------------------------------------------------------------------
+//
+// vmcallbench [function] [count]
+//
+// Measures VMCall round trips from native code into a script function
+// that takes only int arguments, which all get passed as 0.
+//
+//-----------------------------------------------------------------------------
+
+CCMD(vmcallbench)
+{
+	const char *name = argv.argc() > 1 ? argv[1] : "Raze.calcSinTableValue";
+	int count = argv.argc() > 2 ? atoi(argv[2]) : 1000000;
+	if (count <= 0) count = 1000000;
+
+	VMScriptFunction *sfunc = nullptr;
+	for (auto f : VMFunction::AllFunctions)
+	{
+		if (!(f->VarFlags & VARF_Native) && f->PrintableName.CompareNoCase(name) == 0)
+		{
+			sfunc = static_cast<VMScriptFunction *>(f);
+			break;
+		}
+	}
+	if (sfunc == nullptr || sfunc->RegTypes == nullptr)
+	{
+		Printf("Script function %s not found\n", name);
+		return;
+	}
+
+	VMValue params[256];
+	if (sfunc->NumArgs > (int)countof(params))
+	{
+		Printf("%s takes too many arguments\n", name);
+		return;
+	}
+	for (int i = 0; i < sfunc->NumArgs; i++)
+	{
+		if (sfunc->RegTypes[i] != REGT_INT)
+		{
+			Printf("%s must only take int arguments\n", name);
+			return;
+		}
+		params[i] = 0;
+	}
+
+	int result;
+	VMReturn ret(&result);
+	int numret = sfunc->Proto && sfunc->Proto->ReturnTypes.Size() > 0 && sfunc->Proto->ReturnTypes[0]->GetRegType() == REGT_INT;
+
+	VMCall(sfunc, params, sfunc->NumArgs, &ret, numret);	// compiles the function if the JIT is on
+	uint64_t start = I_nsTime();
+	for (int i = 0; i < count; i++)
+	{
+		VMCall(sfunc, params, sfunc->NumArgs, &ret, numret);
+	}
+	double ns = double(I_nsTime() - start);
+	Printf("%s (%s): %d calls in %.3f ms, %.1f ns per call\n", sfunc->PrintableName.GetChars(),
+		sfunc->ScriptCall == VMExec ? "VM" : "JIT", count, ns / 1e6, ns / count);
+}
@@ -361,7 +361,7 @@ public:
 	}
 	static int OffsetLastFrame() { return (int)(ptrdiff_t)offsetof(BlockHeader, LastFrame); }
 private:
-	enum { BLOCK_SIZE = 4096 };		// Default block size
+	enum { BLOCK_SIZE = 256 * 1024 };	// Default block size, large enough that common call depths never need a second block
 	struct BlockHeader
 	{
 		BlockHeader *NextBlock;
@@ -377,6 +377,7 @@ private:
 	BlockHeader *Blocks;
 	BlockHeader *UnusedBlocks;
 	VMFrame *Alloc(int size);
+	VMFrame *AllocInNewBlock(int size);
 };
 
 class VMParamFiller
@@ -478,6 +479,11 @@ public:
 	int AllocExtraStack(PType *type);
 	int PCToLine(const VMOP *pc);
 
+	static int BackgroundJitCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
+
 private:
 	static int FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
+
+	friend void VMStartBackgroundJit();
+	friend void VMShutdownJit();
 };
@@ -36,6 +36,19 @@
 #include "files.h"
 #include "templates.h"	// just for 'clamp'
 #include "zstring.h"
+#include <limits.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 FILE *myfopen(const char *filename, const char *flags)
@@ -349,6 +362,73 @@ public:
 
 
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// maps an entire file into the address space. The mapping is copy-on-write
+// so that lump data modified in place by its users never reaches the file.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+#ifdef _WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = nullptr;
+#endif
+	void *MappedData = nullptr;
+	size_t MappedSize = 0;
+
+public:
+	MappedFileReader()
+	{}
+
+	~MappedFileReader()
+	{
+#ifdef _WIN32
+		if (MappedData != nullptr) UnmapViewOfFile(MappedData);
+		if (hMapping != nullptr) CloseHandle(hMapping);
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+#else
+		if (MappedData != nullptr) munmap(MappedData, MappedSize);
+#endif
+	}
+
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		hFile = CreateFileW(WideString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart <= 0 || size.QuadPart > LONG_MAX) return false;
+		hMapping = CreateFileMappingW(hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (hMapping == nullptr) return false;
+		MappedData = MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+		if (MappedData == nullptr) return false;
+		MappedSize = (size_t)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 || (unsigned long long)info.st_size > LONG_MAX)
+		{
+			close(fd);
+			return false;
+		}
+		void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);	// the mapping keeps its own reference to the file
+		if (data == MAP_FAILED) return false;
+		MappedData = data;
+		MappedSize = (size_t)info.st_size;
+#endif
+		bufptr = (const char*)MappedData;
+		Length = (long)MappedSize;
+		FilePos = 0;
+		return true;
+	}
+};
+
 //==========================================================================
 //
 // FileReader
@@ -370,6 +450,19 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenFileMapped(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return false;
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
@@ -188,8 +188,9 @@ public:
 //==========================================================================
 
 class DecompressorBZ2;
-static DecompressorBZ2 * stupidGlobal;	// Why does that dumb global error callback not pass the decompressor state?
-										// Thanks to that brain-dead interface we have to use a global variable to get the error to the proper handler.
+static thread_local DecompressorBZ2 * stupidGlobal;	// Why does that dumb global error callback not pass the decompressor state?
+													// Thanks to that brain-dead interface we have to use a global variable to get the error to the proper handler.
+													// It is thread local because lumps may be decompressed on several prefetch threads at once.
 
 class DecompressorBZ2 : public DecompressorBase
 {
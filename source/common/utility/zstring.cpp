@@ -158,6 +158,26 @@ FString::~FString ()
 	Data()->Release();
 }
 
+void FString::ConstructEmpty(FString *strings, size_t count)
+{
+	NullString.RefCount += (int)count;
+	for (size_t i = 0; i < count; i++)
+	{
+		strings[i].Chars = &NullString.Nothing[0];
+	}
+}
+
+void FString::DestroyArray(FString *strings, size_t count)
+{
+	int numnull = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (strings[i].Chars == &NullString.Nothing[0]) numnull++;
+		else strings[i].Data()->Release();
+	}
+	NullString.RefCount -= numnull;
+}
+
 char *FString::LockNewBuffer(size_t len)
 {
 	Data()->Release();
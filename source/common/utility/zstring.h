@@ -153,6 +153,12 @@ public:
 
 	~FString ();
 
+	// For arrays of strings in raw memory, like the script VM's string registers.
+	// Both update the empty string's reference count once for the whole array.
+	// DestroyArray still checks every string and releases those that got assigned something.
+	static void ConstructEmpty(FString *strings, size_t count);
+	static void DestroyArray(FString *strings, size_t count);
+
 	// Discard string's contents, create a new buffer, and lock it.
 	char *LockNewBuffer(size_t len);
 
@@ -78,6 +78,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "hw_voxels.h"
 #include "hw_palmanager.h"
 #include "razefont.h"
+#include "startupstats.h"
 
 CVAR(Bool, autoloadlights, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Bool, autoloadbrightmaps, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
@@ -886,16 +887,26 @@ void GetGames()
 
 static void InitTextures()
 {
+	FStartupPhase phase("Textures");
 	TexMan.usefullnames = true;
-	TexMan.Init([]() {}, [](BuildInfo&) {});
+	{
+		FStartupPhase phase("Texture manager");
+		TexMan.Init([]() {}, [](BuildInfo&) {});
+	}
 	StartScreen->Progress();
 	mdinit();
 
-	TileFiles.Init();
-	TileFiles.LoadArtSet("tiles%03d.art"); // it's the same for all games.
+	{
+		FStartupPhase phase("ART files");
+		TileFiles.Init();
+		TileFiles.LoadArtSet("tiles%03d.art"); // it's the same for all games.
+	}
 	voxInit();
 	gi->LoadGameTextures(); // loads game-side data that must be present before processing the .def files.
-	LoadDefinitions();
+	{
+		FStartupPhase phase("Definitions");
+		LoadDefinitions();
+	}
 	InitFont();				// InitFonts may only be called once all texture data has been initialized.
 
 	lookups.postLoadTables();
@@ -932,7 +943,10 @@ int RunGame()
 	I_DetectOS();
 	userConfig.ProcessOptions();
 	G_LoadConfig();
-	GetGames();
+	{
+		FStartupPhase phase("Game scan");
+		GetGames();
+	}
 	auto usedgroups = SetupGame();
 
 	bool colorset = false;
@@ -959,7 +973,10 @@ int RunGame()
 	}
 	I_SetIWADInfo();
 
-	InitFileSystem(usedgroups);
+	{
+		FStartupPhase phase("File system");
+		InitFileSystem(usedgroups);
+	}
 	if (usedgroups.Size() == 0) return 0;
 
 	// Handle CVARs with game specific defaults here.
@@ -1027,9 +1044,15 @@ int RunGame()
 	InitTextures();
 
 	StartScreen->Progress();
-	I_InitSound();
+	{
+		FStartupPhase phase("Sound");
+		I_InitSound();
+	}
 	StartScreen->Progress();
-	Mus_InitMusic();
+	{
+		FStartupPhase phase("Music");
+		Mus_InitMusic();
+	}
 	S_ParseSndInfo();
 	S_ParseReverbDef();
 	InitStatistics();
@@ -1046,7 +1069,10 @@ int RunGame()
 	StartScreen->Progress();
 
 	engineInit();
-	gi->app_init();
+	{
+		FStartupPhase phase("Game init");
+		gi->app_init();
+	}
 	StartScreen->Progress();
 	G_ParseMapInfo();
 	CreateStatusBar();
@@ -1067,7 +1093,10 @@ int RunGame()
 	UpdateJoystickMenu(NULL);
 	UpdateVRModes();
 
-	setVideoMode();
+	{
+		FStartupPhase phase("Video");
+		setVideoMode();
+	}
 
 	LoadVoxelModels();
 	GLInterface.Init(screen->GetWidth());
@@ -1077,6 +1106,7 @@ int RunGame()
 
 	D_CheckNetGame();
 	UpdateGenericUI(ui_generic);
+	StartupStats_Report();
 	MainLoop();
 	return 0; // this is never reached. MainLoop only exits via exception.
 }
@@ -47,6 +47,7 @@
 #include "findfile.h"
 #include "palutil.h"
 #include "startupinfo.h"
+#include "startupstats.h"
 
 #ifndef PATH_MAX
 #define PATH_MAX 260
@@ -408,7 +409,10 @@ void InitFileSystem(TArray<GrpEntry>& groups)
 	{
 		DeleteStuff(fileSystem, todelete, groups.Size());
 	};
-	fileSystem.InitMultipleFiles(Files, false, &lfi);
+	{
+		FStartupPhase phase("InitMultipleFiles");
+		fileSystem.InitMultipleFiles(Files, false, &lfi);
+	}
 	if (Args->CheckParm("-dumpfs"))
 	{
 		FILE* f = fopen("filesystem.dir", "wb");
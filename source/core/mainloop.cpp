@@ -703,6 +703,7 @@ void MainLoop ()
 				I_StartFrame ();
 			}
 			I_SetFrameTime();
+			GC::BeginFrame();
 
 			TryRunTics (); // will run at least one tic
 			// Update display, next frame, with current state.
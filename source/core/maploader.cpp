@@ -45,8 +45,64 @@
 #include "sectorgeometry.h"
 #include "render.h"
 #include "hw_sections.h"
+#include "filesystem.h"
+#include "image.h"
+#include "m_argv.h"
+#include "i_time.h"
+
+//==========================================================================
+//
+// Decodes the map's little-endian fields straight out of the file buffer.
+// Reads past the end return 0.
+//
+//==========================================================================
+
+class MapReader
+{
+	const uint8_t* ptr;
+	const uint8_t* end;
+
+	const uint8_t* Get(size_t size)
+	{
+		if (size_t(end - ptr) < size)
+		{
+			ptr = end;
+			return nullptr;
+		}
+		auto p = ptr;
+		ptr += size;
+		return p;
+	}
+
+public:
+	MapReader(const TArray<uint8_t>& buffer) : ptr(buffer.Data()), end(buffer.Data() + buffer.Size()) {}
+
+	void Skip(size_t size) { Get(size); }
+
+	uint8_t ReadUInt8()
+	{
+		auto p = Get(1);
+		return p ? p[0] : 0;
+	}
 
-static void ReadSectorV7(FileReader& fr, sectortype& sect)
+	int8_t ReadInt8() { return (int8_t)ReadUInt8(); }
+
+	uint16_t ReadUInt16()
+	{
+		auto p = Get(2);
+		return p ? uint16_t(p[0] | (p[1] << 8)) : 0;
+	}
+
+	int16_t ReadInt16() { return (int16_t)ReadUInt16(); }
+
+	int32_t ReadInt32()
+	{
+		auto p = Get(4);
+		return p ? int32_t(p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24)) : 0;
+	}
+};
+
+static void ReadSectorV7(MapReader& fr, sectortype& sect)
 {
 	sect.wallptr = fr.ReadInt16();
 	sect.wallnum = fr.ReadInt16();
@@ -73,7 +129,7 @@ static void ReadSectorV7(FileReader& fr, sectortype& sect)
 	sect.extra = fr.ReadInt16();
 }
 
-static void ReadSectorV6(FileReader& fr, sectortype& sect)
+static void ReadSectorV6(MapReader& fr, sectortype& sect)
 {
 	sect.wallptr = fr.ReadUInt16();
 	sect.wallnum = fr.ReadUInt16();
@@ -100,7 +156,7 @@ static void ReadSectorV6(FileReader& fr, sectortype& sect)
 }
 
 
-static void ReadSectorV5(FileReader& fr, sectortype& sect)
+static void ReadSectorV5(MapReader& fr, sectortype& sect)
 {
 	sect.wallptr = fr.ReadInt16();
 	sect.wallnum = fr.ReadInt16();
@@ -128,7 +184,7 @@ static void ReadSectorV5(FileReader& fr, sectortype& sect)
 	if ((sect.floorstat & 2) == 0) sect.floorheinum = 0;
 }
 
-static void ReadWallV7(FileReader& fr, walltype& wall)
+static void ReadWallV7(MapReader& fr, walltype& wall)
 {
 	wall.pos.x = fr.ReadInt32();
 	wall.pos.y = fr.ReadInt32();
@@ -149,7 +205,7 @@ static void ReadWallV7(FileReader& fr, walltype& wall)
 	wall.extra = fr.ReadInt16();
 }
 
-static void ReadWallV6(FileReader& fr, walltype& wall)
+static void ReadWallV6(MapReader& fr, walltype& wall)
 {
 	wall.pos.x = fr.ReadInt32();
 	wall.pos.y = fr.ReadInt32();
@@ -170,7 +226,7 @@ static void ReadWallV6(FileReader& fr, walltype& wall)
 	wall.extra = fr.ReadInt16();
 }
 
-static void ReadWallV5(FileReader& fr, walltype& wall)
+static void ReadWallV5(MapReader& fr, walltype& wall)
 {
 	wall.pos.x = fr.ReadInt32();
 	wall.pos.y = fr.ReadInt32();
@@ -186,7 +242,7 @@ static void ReadWallV5(FileReader& fr, walltype& wall)
 
 	wall.nextsector = fr.ReadInt16();
 	wall.nextwall = fr.ReadInt16();
-	fr.Seek(4, FileReader::SeekSet); // skip over 2 unused 16 bit values
+	fr.Skip(4); // skip over 2 unused 16 bit values
 
 	wall.lotag = fr.ReadInt16();
 	wall.hitag = fr.ReadInt16();
@@ -238,7 +294,7 @@ static void ValidateSprite(spritetype& spr)
 	}
 }
 
-static void ReadSpriteV7(FileReader& fr, spritetype& spr)
+static void ReadSpriteV7(MapReader& fr, spritetype& spr)
 {
 	spr.pos.x = fr.ReadInt32();
 	spr.pos.y = fr.ReadInt32();
@@ -267,7 +323,7 @@ static void ReadSpriteV7(FileReader& fr, spritetype& spr)
 	ValidateSprite(spr);
 }
 
-static void ReadSpriteV6(FileReader& fr, spritetype& spr)
+static void ReadSpriteV6(MapReader& fr, spritetype& spr)
 {
 	spr.pos.x = fr.ReadInt32();
 	spr.pos.y = fr.ReadInt32();
@@ -296,7 +352,7 @@ static void ReadSpriteV6(FileReader& fr, spritetype& spr)
 	ValidateSprite(spr);
 }
 
-static void ReadSpriteV5(FileReader& fr, spritetype& spr)
+static void ReadSpriteV5(MapReader& fr, spritetype& spr)
 {
 	spr.pos.x = fr.ReadInt32();
 	spr.pos.y = fr.ReadInt32();
@@ -373,20 +429,68 @@ static void insertAllSprites(const char* filename, const vec3_t* pos, int16_t* c
 
 void addBlockingPairs();
 
+//==========================================================================
+//
+// Starts decompressing the images of all textures the map references
+// while the rest of the level setup runs.
+//
+//==========================================================================
+
+static FPrefetchHandle PrefetchMapTextures(int numsprites)
+{
+	TArray<int> lumps;
+	TMap<int, bool> seen;
+	auto addtile = [&](int tilenum)
+	{
+		if ((unsigned)tilenum >= MAXTILES || seen.CheckKey(tilenum)) return;
+		seen.Insert(tilenum, true);
+		auto tex = tileGetTexture(tilenum);
+		if (!tex || !tex->isValid()) return;
+		auto image = tex->GetTexture()->GetImage();
+		if (image && image->LumpNum() >= 0) lumps.Push(image->LumpNum());
+	};
+
+	for (int i = 0; i < numsectors; i++)
+	{
+		addtile(sector[i].ceilingpicnum);
+		addtile(sector[i].floorpicnum);
+	}
+	for (int i = 0; i < numwalls; i++)
+	{
+		addtile(wall[i].picnum);
+		addtile(wall[i].overpicnum);
+	}
+	for (int i = 0; i < numsprites; i++)
+	{
+		if (sprite[i].statnum < MAXSTATUS) addtile(sprite[i].picnum);
+	}
+	return fileSystem.Prefetch(lumps);
+}
+
 void engineLoadBoard(const char* filename, int flags, vec3_t* pos, int16_t* ang, int16_t* cursectnum)
 {
+	uint64_t time[6];
+	time[0] = I_nsTime();
+
 	inputState.ClearAllInput();
 	memset(sector, 0, sizeof(*sector) * MAXSECTORS);
 	memset(wall, 0, sizeof(*wall) * MAXWALLS);
 	memset(sprite, 0, sizeof(*sector) * MAXSPRITES);
 
-	FileReader fr = fileSystem.OpenFileReader(filename);
-	if (!fr.isOpen()) I_Error("Unable to open map %s", filename);
+	// The whole map is decoded from one buffer which is also used for the MD4 below.
+	TArray<uint8_t> buffer;
+	{
+		FileReader mapfile = fileSystem.OpenFileReader(filename);
+		if (!mapfile.isOpen()) I_Error("Unable to open map %s", filename);
+		buffer = mapfile.Read();
+	}
+	MapReader fr(buffer);
 	int mapversion = fr.ReadInt32();
 	if (mapversion < 5 || mapversion > 9) // 9 is most likely useless but let's try anyway.
 	{
 		I_Error("%s: Invalid map format, expcted 5-9, got %d", filename, mapversion);
 	}
+	time[1] = I_nsTime();
 
 	memset(spriteext, 0, sizeof(spriteext_t) * MAXSPRITES);
 	memset(spritesmooth, 0, sizeof(spritesmooth_t) * (MAXSPRITES + MAXUNIQHUDID));
@@ -437,6 +541,12 @@ void engineLoadBoard(const char* filename, int flags, vec3_t* pos, int16_t* ang,
 	}
 
 	artSetupMapArt(filename);
+	time[2] = I_nsTime();
+
+	// All referenced picnums are known now, so the texture data can be decoded on the worker threads
+	// while the sprite lists and sections get built.
+	auto prefetch = PrefetchMapTextures(numsprites);
+
 	insertAllSprites(filename, pos, cursectnum, numsprites);
 
 	for (int i = 0; i < numsprites; i++)
@@ -446,11 +556,11 @@ void engineLoadBoard(const char* filename, int flags, vec3_t* pos, int16_t* ang,
 	//Must be last.
 	updatesector(pos->x, pos->y, cursectnum);
 	guniqhudid = 0;
-	fr.Seek(0, FileReader::SeekSet);
-	auto buffer = fr.Read();
 	unsigned char md4[16];
 	md4once(buffer.Data(), buffer.Size(), md4);
 	G_LoadMapHack(filename, md4);
+	time[3] = I_nsTime();
+
 	setWallSectors();
 	hw_BuildSections();
 	sectorGeometry.SetSize(numsections);
@@ -458,6 +568,17 @@ void engineLoadBoard(const char* filename, int flags, vec3_t* pos, int16_t* ang,
 
 	memcpy(wallbackup, wall, sizeof(wallbackup));
 	memcpy(sectorbackup, sector, sizeof(sectorbackup));
+	time[4] = I_nsTime();
+
+	prefetch.Wait();
+	time[5] = I_nsTime();
+
+	if (Args->CheckParm("-loadstats"))
+	{
+		Printf("%s: read %.2f ms, parse %.2f ms, setup %.2f ms, sections %.2f ms, prefetch wait %.2f ms, total %.2f ms\n", filename,
+			(time[1] - time[0]) / 1e6, (time[2] - time[1]) / 1e6, (time[3] - time[2]) / 1e6, (time[4] - time[3]) / 1e6,
+			(time[5] - time[4]) / 1e6, (time[5] - time[0]) / 1e6);
+	}
 }
 
 
@@ -43,6 +43,8 @@
 #include "hw_models.h"
 #include "hw_voxels.h"
 #include "mapinfo.h"
+#include "filesystem.h"
+#include "image.h"
 
 BEGIN_BLD_NS
 extern short voxelIndex[MAXTILES];
@@ -123,8 +125,22 @@ void markTileForPrecache(int tilenum, int palnum)
 void precacheMarkedTiles()
 {
 	screen->StartPrecaching();
-	decltype(cachemap)::Iterator it(cachemap);
+
+	// Decompress the source lumps of all marked textures on the worker pool first.
+	TArray<int> lumps;
+	decltype(cachemap)::Iterator itl(cachemap);
 	decltype(cachemap)::Pair* pair;
+	while (itl.NextPair(pair))
+	{
+		auto tex = tileGetTexture(pair->Key & 0x7fffffff);
+		if (!tex || !tex->isValid()) continue;
+		auto image = tex->GetTexture()->GetImage();
+		if (image && image->LumpNum() >= 0) lumps.Push(image->LumpNum());
+	}
+	auto prefetch = fileSystem.Prefetch(lumps);
+	prefetch.Wait();
+
+	decltype(cachemap)::Iterator it(cachemap);
 	while (it.NextPair(pair))
 	{
 		int dapicnum = pair->Key & 0x7fffffff;
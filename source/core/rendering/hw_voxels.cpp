@@ -30,6 +30,7 @@
 #include "voxels.h"
 #include "hw_voxels.h"
 #include "gamecontrol.h"
+#include "filesystem.h"
 
 int16_t tiletovox[MAXTILES];
 static int voxlumps[MAXVOXELS];
@@ -90,6 +91,17 @@ static voxmodel_t* voxload(int lumpnum)
 
 void LoadVoxelModels()
 {
+	// Decompress all voxel lumps on the worker pool first.
+	TArray<int> lumps(MAXVOXELS, true);
+	TArray<int> prefetchlumps;
+	for (int i = 0; i < MAXVOXELS; i++)
+	{
+		lumps[i] = voxlumps[i] > 0 ? voxlumps[i] : fileSystem.FindResource(i, "KVX");
+		if (lumps[i] >= 0) prefetchlumps.Push(lumps[i]);
+	}
+	auto prefetch = fileSystem.Prefetch(prefetchlumps);
+	prefetch.Wait();
+
 	for (int i = 0; i < MAXVOXELS; i++)
 	{
 		int lumpnum = voxlumps[i];
@@ -101,13 +113,9 @@ void LoadVoxelModels()
 			else
 				Printf("Unable to load voxel from %s\n", fileSystem.GetFileFullPath(lumpnum).GetChars());
 		}
-		else 
+		else if (lumps[i] >= 0)
 		{
-			auto index = fileSystem.FindResource(i, "KVX");
-			if (index >= 0)
-			{
-				voxmodels[i] = voxload(index);
-			}
+			voxmodels[i] = voxload(lumps[i]);
 		}
 	}
 }
@@ -46,6 +46,8 @@
 #include "m_argv.h"
 #include "filesystem.h"
 #include "findfile.h"
+#include "ctpl.h"
+#include "startupstats.h"
 
 static const char* res_exts[] = { ".grp", ".zip", ".pk3", ".pk4", ".7z", ".pk7" };
 
@@ -329,20 +331,77 @@ TArray<FileEntry> CollectAllFilesInSearchPath()
 //
 //==========================================================================
 
-static TArray<FileEntry> LoadCRCCache(void)
+using FCRCCache = TMap<FString, FileEntry>;
+
+static const char CRCCacheMagic[4] = { 'G', 'C', 'R', 'C' };
+enum { CRCCacheVersion = 1 };
+
+//==========================================================================
+//
+// The cache is a flat binary file: magic, version and entry count,
+// followed by (name length, name, size, time, crc) per entry.
+//
+//==========================================================================
+
+static bool LoadBinaryCRCCache(const FString &cachepath, FCRCCache &crcmap)
+{
+	FileReader fr;
+	if (!fr.OpenFile(cachepath)) return false;
+
+	auto buffer = fr.Read();
+	auto p = buffer.Data();
+	auto end = p + buffer.Size();
+	auto get32 = [](const uint8_t* b) { return uint32_t(b[0] | (b[1] << 8) | (b[2] << 16) | (uint32_t(b[3]) << 24)); };
+	if (buffer.Size() < 12 || memcmp(p, CRCCacheMagic, 4) || get32(p + 4) != CRCCacheVersion) return false;
+
+	uint32_t count = get32(p + 8);
+	p += 12;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (end - p < 4) break;
+		uint32_t namelen = get32(p);
+		if ((size_t)(end - p) < 4 + namelen + 20) break;
+
+		FileEntry entry;
+		entry.FileName = FString((const char*)p + 4, namelen);
+		p += 4 + namelen;
+		entry.FileLength = (size_t)(get32(p) | (uint64_t(get32(p + 4)) << 32));
+		entry.FileTime = (time_t)(get32(p + 8) | (uint64_t(get32(p + 12)) << 32));
+		entry.CRCValue = get32(p + 16);
+		entry.Index = 0;
+		p += 20;
+		crcmap.Insert(entry.FileName, entry);
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Reads the binary cache, or the old text format if there is no binary
+// cache yet, so that existing CRCs are not recalculated after an update.
+// 'legacy' tells whether the text file was used, in which case the binary
+// cache still needs to be written.
+//
+//==========================================================================
+
+static FCRCCache LoadCRCCache(bool &legacy)
 {
+	FCRCCache crcmap;
+	legacy = false;
+	if (LoadBinaryCRCCache(M_GetAppDataPath(false) + "/grpcrccache.bin", crcmap))
+		return crcmap;
+
 	auto cachepath = M_GetAppDataPath(false) + "/grpcrccache.txt";
 	FScanner sc;
-	TArray<FileEntry> crclist;
 
 	try
 	{
 		if (sc.OpenFile(cachepath))
 		{
+			legacy = true;
 			while (sc.GetString())
 			{
-				crclist.Reserve(1);
-				auto &flentry = crclist.Last();
+				FileEntry flentry;
 				flentry.FileName = sc.String;
 				sc.MustGetNumber();
 				flentry.FileLength = sc.BigNumber;
@@ -350,6 +409,8 @@ static TArray<FileEntry> LoadCRCCache(void)
 				flentry.FileTime = sc.BigNumber;
 				sc.MustGetNumber();
 				flentry.CRCValue = (unsigned)sc.BigNumber;
+				flentry.Index = 0;
+				crcmap.Insert(flentry.FileName, flentry);
 			}
 		}
 	}
@@ -357,7 +418,7 @@ static TArray<FileEntry> LoadCRCCache(void)
 	{
 		// If there's a parsing error, return what we got and discard the rest.
 	}
-	return crclist;
+	return crcmap;
 }
 
 //==========================================================================
@@ -366,17 +427,35 @@ static TArray<FileEntry> LoadCRCCache(void)
 //
 //==========================================================================
 
-void SaveCRCs(TArray<FileEntry>& crclist)
+void SaveCRCs(FCRCCache& crcmap)
 {
-	auto cachepath = M_GetAppDataPath(true) + "/grpcrccache.txt";
+	auto cachepath = M_GetAppDataPath(true) + "/grpcrccache.bin";
 
 	FileWriter* fw = FileWriter::Open(cachepath);
 	if (fw)
 	{
-		for (auto& crc : crclist)
+		auto put32 = [=](uint32_t v)
+		{
+			uint8_t b[4] = { uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24) };
+			fw->Write(b, 4);
+		};
+
+		fw->Write(CRCCacheMagic, 4);
+		put32(CRCCacheVersion);
+		put32(crcmap.CountUsed());
+
+		FCRCCache::Iterator it(crcmap);
+		FCRCCache::Pair* pair;
+		while (it.NextPair(pair))
 		{
-			FStringf line("\"%s\" %llu %llu %u\n", crc.FileName.GetChars(), (long long)crc.FileLength, (long long)crc.FileTime, crc.CRCValue);
-			fw->Write(line.GetChars(), line.Len());
+			auto& crc = pair->Value;
+			put32((uint32_t)crc.FileName.Len());
+			fw->Write(crc.FileName.GetChars(), crc.FileName.Len());
+			put32(uint32_t(uint64_t(crc.FileLength)));
+			put32(uint32_t(uint64_t(crc.FileLength) >> 32));
+			put32(uint32_t(uint64_t(crc.FileTime)));
+			put32(uint32_t(uint64_t(crc.FileTime) >> 32));
+			put32(crc.CRCValue);
 		}
 		delete fw;
 	}
@@ -663,34 +742,107 @@ TArray<GrpInfo> ParseAllGrpInfos(TArray<FileEntry>& filelist)
 //
 //==========================================================================
 					
-void GetCRC(FileEntry *entry, TArray<FileEntry> &CRCCache)
+//==========================================================================
+//
+// Calculates the CRCs of all files not found in the cache.
+// Files are split into fixed size chunks which are checksummed in
+// parallel and then merged with crc32_combine, so the result is identical
+// to a single sequential pass, even for one huge GRP.
+//
+//==========================================================================
+
+enum { CRCChunkSize = 16 * 1024 * 1024 };
+
+struct FCRCChunk
+{
+	FileEntry *Entry;
+	size_t Start;
+	size_t Length;
+	uint32_t CRC;
+	bool Ok;
+};
+
+static void CalcCRCChunk(FCRCChunk &chunk)
 {
-	for (auto &ce : CRCCache)
-	{
-		// File size, modification date snd name all must match exactly to pick an entry.
-		if (entry->FileLength == ce.FileLength && entry->FileTime == ce.FileTime && entry->FileName.Compare(ce.FileName) == 0)
-		{
-			entry->CRCValue = ce.CRCValue;
-			return;
-		}
-	}
 	FileReader f;
-	if (f.OpenFile(entry->FileName))
+	chunk.CRC = 0;
+	chunk.Ok = false;
+	if (f.OpenFile(chunk.Entry->FileName, chunk.Start, chunk.Length))
 	{
 		TArray<uint8_t> buffer(65536, 1);
-		uint32_t crcval = 0;
+		size_t total = 0;
 		size_t b;
 		do
 		{
 			b = f.Read(buffer.Data(), buffer.Size());
-			if (b > 0) crcval = AddCRC32(crcval, buffer.Data(), unsigned(b));
+			if (b > 0) chunk.CRC = AddCRC32(chunk.CRC, buffer.Data(), unsigned(b));
+			total += b;
 		}
 		while (b == buffer.Size());
-		entry->CRCValue = crcval;
-		CRCCache.Push(*entry);
+		chunk.Ok = total == chunk.Length;
 	}
 }
 
+int GetCRCs(TArray<FileEntry*> &entries, FCRCCache &crcmap)
+{
+	TArray<FCRCChunk> chunks;
+	for (auto entry : entries)
+	{
+		auto ce = crcmap.CheckKey(entry->FileName);
+		// File size, modification date and name all must match exactly to pick an entry.
+		if (ce && entry->FileLength == ce->FileLength && entry->FileTime == ce->FileTime)
+		{
+			entry->CRCValue = ce->CRCValue;
+			continue;
+		}
+		entry->CRCValue = 0;
+		size_t pos = 0;
+		do
+		{
+			size_t len = MIN<size_t>(entry->FileLength - pos, CRCChunkSize);
+			chunks.Push({ entry, pos, len, 0, false });
+			pos += len;
+		} while (pos < entry->FileLength);
+	}
+	if (chunks.Size() == 0) return 0;
+
+	if (chunks.Size() == 1)
+	{
+		CalcCRCChunk(chunks[0]);
+	}
+	else
+	{
+		int numthreads = MIN<int>(std::max<int>(std::thread::hardware_concurrency(), 1), chunks.Size());
+		ctpl::thread_pool pool(numthreads);
+		for (auto& chunk : chunks)
+		{
+			pool.push([&chunk](int) { CalcCRCChunk(chunk); });
+		}
+		pool.stop(true);
+	}
+
+	// Merge the chunks in file order.
+	int added = 0;
+	for (unsigned i = 0; i < chunks.Size(); )
+	{
+		auto entry = chunks[i].Entry;
+		uint32_t crcval = 0;
+		bool ok = true;
+		for (; i < chunks.Size() && chunks[i].Entry == entry; i++)
+		{
+			ok &= chunks[i].Ok;
+			crcval = chunks[i].Start == 0 ? chunks[i].CRC : (uint32_t)crc32_combine(crcval, chunks[i].CRC, (z_off_t)chunks[i].Length);
+		}
+		if (ok)
+		{
+			entry->CRCValue = crcval;
+			crcmap.Insert(entry->FileName, *entry);
+			added++;
+		}
+	}
+	return added;
+}
+
 GrpInfo *IdentifyGroup(FileEntry *entry, TArray<GrpInfo *> &groups)
 {
 	for (auto g : groups)
@@ -742,11 +894,12 @@ TArray<GrpEntry> GrpScan()
 	TArray<GrpInfo*> contentGroupList;
 	TArray<GrpInfo*> addonList;
 
+	FStartupPhase phase("Game data identification");
 	auto allFiles = CollectAllFilesInSearchPath();
 	auto allGroups = ParseAllGrpInfos(allFiles);
 
-	auto cachedCRCs = LoadCRCCache();
-	auto numCRCs = cachedCRCs.Size();
+	bool legacyCRCCache;
+	auto cachedCRCs = LoadCRCCache(legacyCRCCache);
 
 	for (unsigned i = 0; i < allGroups.Size(); i++)
 		allGroups[i].index = i;
@@ -843,9 +996,13 @@ TArray<GrpEntry> GrpScan()
 	if (sortedGroupList.Size() == 0 || sortedFileList.Size() == 0)
 		return foundGames;
 
+	int newCRCs;
+	{
+		FStartupPhase phase("CRC calculation");
+		newCRCs = GetCRCs(sortedFileList, cachedCRCs);
+	}
 	for (auto entry : sortedFileList)
 	{
-		GetCRC(entry, cachedCRCs);
 		auto grp = IdentifyGroup(entry, sortedGroupList);
 		if (grp)
 		{
@@ -903,8 +1060,8 @@ TArray<GrpEntry> GrpScan()
 		}
 	}
 
-	// new CRCs got added so save the list.
-	if (cachedCRCs.Size() > numCRCs)
+	// new CRCs got added or the list came from the old text file so save it.
+	if (newCRCs > 0 || legacyCRCCache)
 	{
 		SaveCRCs(cachedCRCs);
 	}
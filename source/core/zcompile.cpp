@@ -42,6 +42,8 @@
 #include "stats.h"
 #include "printf.h"
 #include "dobject.h"
+#include "startupstats.h"
+#include "vm.h"
 
 void InitImports();
 
@@ -75,6 +77,7 @@ void ParseScripts()
 
 void LoadScripts()
 {
+	FStartupPhase phase("Scripts");
 	cycle_t timer;
 
 	PClass::StaticInit();
@@ -84,9 +87,15 @@ void LoadScripts()
 	FScriptPosition::ResetErrorCounter();
 
 	FScriptPosition::StrictErrors = true;
-	ParseScripts();
+	{
+		FStartupPhase phase("ZScript compile");
+		ParseScripts();
+	}
 
-	FunctionBuildList.Build();
+	{
+		FStartupPhase phase("ZScript code generation");
+		FunctionBuildList.Build();
+	}
 
 	if (FScriptPosition::ErrorCounter > 0)
 	{
@@ -97,6 +106,9 @@ void LoadScripts()
 	timer.Unclock();
 	if (!batchrun) Printf("script parsing took %.2f ms\n", timer.TimeMS());
 
+	// Queue the functions for the background JIT compiler if vm_jit_aot asks for it.
+	VMStartBackgroundJit();
+
 	// Now we may call the scripted OnDestroy method.
 	PClass::bVMOperational = true;
 }
@@ -23,7 +23,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 //-------------------------------------------------------------------------
 
 #include "ns.h"
-#include <set>
 #include "build.h"
 #include "printf.h"
 #include "blood.h"
@@ -38,48 +37,182 @@ const int kMaxID = 1024;
 RXBUCKET rxBucket[kChannelMax];
 unsigned short bucketHead[kMaxID + 1];
 static int bucketCount;
-static std::multiset<EVENT> queue;
 
 //---------------------------------------------------------------------------
 //
-//
+// The queue of pending events: a binary heap ordered by time, and by order
+// of posting for events due at the same time.
+// The queued events of each object are also linked together, so that
+// evKill only needs to look at those.
 //
 //---------------------------------------------------------------------------
 
-static int GetBucketChannel(const RXBUCKET* pBucket)
+class EventQueue
 {
-	int nXIndex;
-	switch (pBucket->type)
+	struct Node
 	{
-	case SS_SECTOR:
-		nXIndex = sector[pBucket->index].extra;
-		assert(nXIndex > 0);
-		return xsector[nXIndex].rxID;
+		EVENT event;
+		uint64_t sequence;
+		int heapPos;			// -1 while the node is unused.
+		int prevSame, nextSame;	// other queued events of the same object.
+	};
+
+	TArray<Node> nodes;
+	TArray<int> heap;
+	TArray<int> freeNodes;
+	TMap<int, int> objectEvents;	// first node for each object.
+	uint64_t sequence = 0;
+
+	static int ObjectKey(int index, int type)
+	{
+		return (int)(((uint8_t)type << 16) | (uint16_t)index);
+	}
 
-	case SS_WALL:
-		nXIndex = wall[pBucket->index].extra;
-		assert(nXIndex > 0);
-		return xwall[nXIndex].rxID;
+	bool Less(int a, int b) const
+	{
+		auto& na = nodes[a];
+		auto& nb = nodes[b];
+		if (na.event.priority != nb.event.priority) return na.event.priority < nb.event.priority;
+		return na.sequence < nb.sequence;
+	}
 
-	case SS_SPRITE:
-		nXIndex = sprite[pBucket->index].extra;
-		assert(nXIndex > 0);
-		return xsprite[nXIndex].rxID;
+	void Place(int pos, int node)
+	{
+		heap[pos] = node;
+		nodes[node].heapPos = pos;
 	}
 
-	Printf(PRINT_HIGH, "Unexpected rxBucket type %d", pBucket->type);
-	return 0;
-}
+	void SiftUp(int pos)
+	{
+		int node = heap[pos];
+		while (pos > 0)
+		{
+			int parent = (pos - 1) / 2;
+			if (!Less(node, heap[parent])) break;
+			Place(pos, heap[parent]);
+			pos = parent;
+		}
+		Place(pos, node);
+	}
 
-//---------------------------------------------------------------------------
-//
-//
-//
-//---------------------------------------------------------------------------
+	void SiftDown(int pos)
+	{
+		int node = heap[pos];
+		int count = heap.Size();
+		for (;;)
+		{
+			int child = pos * 2 + 1;
+			if (child >= count) break;
+			if (child + 1 < count && Less(heap[child + 1], heap[child])) child++;
+			if (!Less(heap[child], node)) break;
+			Place(pos, heap[child]);
+			pos = child;
+		}
+		Place(pos, node);
+	}
+
+	void Remove(int node)
+	{
+		// unlink from the object's list.
+		auto& n = nodes[node];
+		if (n.prevSame >= 0) nodes[n.prevSame].nextSame = n.nextSame;
+		else
+		{
+			int key = ObjectKey(n.event.index, n.event.type);
+			if (n.nextSame >= 0) objectEvents[key] = n.nextSame;
+			else objectEvents.Remove(key);
+		}
+		if (n.nextSame >= 0) nodes[n.nextSame].prevSame = n.prevSame;
+
+		// and from the heap.
+		int pos = n.heapPos;
+		int last;
+		heap.Pop(last);
+		if (last != node)
+		{
+			Place(pos, last);
+			SiftUp(pos);
+			SiftDown(nodes[last].heapPos);
+		}
+		n.heapPos = -1;
+		freeNodes.Push(node);
+	}
+
+public:
+	void clear()
+	{
+		nodes.Clear();
+		heap.Clear();
+		freeNodes.Clear();
+		objectEvents.Clear();
+		sequence = 0;
+	}
+
+	unsigned size() const
+	{
+		return heap.Size();
+	}
+
+	const EVENT& top() const
+	{
+		return nodes[heap[0]].event;
+	}
+
+	void insert(const EVENT& ev)
+	{
+		int node;
+		if (!freeNodes.Pop(node)) node = nodes.Reserve(1);
+		auto& n = nodes[node];
+		n.event = ev;
+		n.sequence = sequence++;
+
+		int key = ObjectKey(ev.index, ev.type);
+		int* first = objectEvents.CheckKey(key);
+		n.prevSame = -1;
+		n.nextSame = first ? *first : -1;
+		if (first) nodes[*first].prevSame = node;
+		objectEvents[key] = node;
+
+		heap.Push(node);
+		SiftUp(heap.Size() - 1);
+	}
+
+	EVENT pop()
+	{
+		EVENT ev = top();
+		Remove(heap[0]);
+		return ev;
+	}
+
+	template<class Pred> void kill(int index, int type, Pred pred)
+	{
+		int* first = objectEvents.CheckKey(ObjectKey(index, type));
+		int node = first ? *first : -1;
+		while (node >= 0)
+		{
+			int next = nodes[node].nextSame;
+			if (pred(nodes[node].event)) Remove(node);
+			node = next;
+		}
+	}
+
+	// All queued events in the order they will be processed.
+	TArray<EVENT> sorted() const
+	{
+		TArray<int> order(heap.Size(), true);
+		memcpy(order.Data(), heap.Data(), heap.Size() * sizeof(int));
+		std::sort(order.begin(), order.end(), [=](int a, int b) { return Less(a, b); });
+		TArray<EVENT> events(order.Size(), true);
+		for (unsigned i = 0; i < order.Size(); i++) events[i] = nodes[order[i]].event;
+		return events;
+	}
+};
+
+static EventQueue queue;
 
 static int CompareChannels(const RXBUCKET* ref1, const RXBUCKET* ref2)
 {
-	return GetBucketChannel(ref1) - GetBucketChannel(ref2);
+	return ref1->channel - ref2->channel;
 }
 
 //---------------------------------------------------------------------------
@@ -250,7 +383,7 @@ static void createBucketHeads()
 	for (i = 0, j = 0; i < kMaxID; i++)
 	{
 		bucketHead[i] = (short)j;
-		while (j < bucketCount && GetBucketChannel(&rxBucket[j]) == i)
+		while (j < bucketCount && rxBucket[j].channel == i)
 		{
 			j++;
 		}
@@ -280,6 +413,7 @@ void evInit()
 			assert(nCount < kChannelMax);
 			rxBucket[nCount].type = SS_SECTOR;
 			rxBucket[nCount].index = i;
+			rxBucket[nCount].channel = xsector[nXSector].rxID;
 			nCount++;
 		}
 	}
@@ -292,6 +426,7 @@ void evInit()
 			assert(nCount < kChannelMax);
 			rxBucket[nCount].type = SS_WALL;
 			rxBucket[nCount].index = i;
+			rxBucket[nCount].channel = xwall[nXWall].rxID;
 			nCount++;
 		}
 	}
@@ -306,6 +441,7 @@ void evInit()
 				assert(nCount < kChannelMax);
 				rxBucket[nCount].type = SS_SPRITE;
 				rxBucket[nCount].index = i;
+				rxBucket[nCount].channel = xsprite[nXSprite].rxID;
 				nCount++;
 			}
 		}
@@ -545,20 +681,12 @@ void evPost(DBloodActor* actor, unsigned int nDelta, CALLBACK_ID callback)
 
 void evKill(int index, int type)
 {
-	for (auto ev = queue.begin(); ev != queue.end();)
-	{
-		if (ev->index == index && ev->type == type) ev = queue.erase(ev);
-		else ev++;
-	}
+	queue.kill(index, type, [](const EVENT&) { return true; });
 }
 
 void evKill(int index, int type, CALLBACK_ID cb)
 {
-	for (auto ev = queue.begin(); ev != queue.end();)
-	{
-		if (ev->index == index && ev->type == type && ev->funcID == cb) ev = queue.erase(ev);
-		else ev++;
-	}
+	queue.kill(index, type, [=](const EVENT& ev) { return ev.funcID == cb; });
 }
 
 void evKill(DBloodActor* actor)
@@ -574,10 +702,9 @@ void evKill(DBloodActor* actor)
 
 void evProcess(unsigned int time)
 {
-	while (queue.size() > 0 && (int)time >= queue.begin()->priority)
+	while (queue.size() > 0 && (int)time >= queue.top().priority)
 	{
-		EVENT event = *queue.begin();
-		queue.erase(queue.begin());
+		EVENT event = queue.pop();
 
 		if (event.cmd == kCmdCallback)
 		{
@@ -664,7 +791,7 @@ void SerializeEvents(FSerializer& arc)
 			}
 			else
 			{
-				for (auto item : queue)
+				for (auto item : queue.sorted())
 				{
 					arc(nullptr, item);
 				}
@@ -75,6 +75,7 @@ struct RXBUCKET
 {
     uint16_t index;
     uint8_t type;
+    uint16_t channel;	// only used while evInit sorts the buckets, not saved.
 };
 extern void (*gCallback[])(int);
 extern RXBUCKET rxBucket[];
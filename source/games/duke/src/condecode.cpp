@@ -0,0 +1,734 @@
+//-------------------------------------------------------------------------
+/*
+Copyright (C) 2021 - Raze developers
+
+This file is part of Raze.
+
+Raze is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+//-------------------------------------------------------------------------
+
+// Alternative execution engines for CON code.
+//
+// The unit of compilation is a statement list, i.e. everything 'while (!parse());'
+// executes starting at a given address: an actor's code, an event or a state.
+// ConCodeCompiler breaks it into simple steps: flow control (braces, if/else,
+// state calls) and the most common actor commands are translated, everything
+// else is handed to the interpreter one command at a time. After each such
+// command the translated code checks that insptr ended up where the compiler
+// expected it. If not, the interpreter takes over for the rest of the list,
+// so the result is always the same as with parse() alone, including the order
+// of all random number calls.
+//
+// The steps are either turned into machine code (conjit.cpp) or into a
+// pre-decoded instruction stream which is run by a threaded interpreter.
+
+#include "ns.h"
+#include "concmd.h"
+#include "duke3d.h"
+#include "gamevar.h"
+#include "condecode.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "i_time.h"
+#include "memarena.h"
+
+CUSTOM_CVAR(Int, con_engine, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0 || self >= Duke3d::NUM_CONENGINES) self = 0;
+}
+
+BEGIN_DUKE_NS
+
+//---------------------------------------------------------------------------
+//
+// Commands that are left to the interpreter but always continue right behind
+// their operands. Everything not listed here ends the translated part of a list.
+//
+//---------------------------------------------------------------------------
+
+static const struct
+{
+	int op;
+	int length;
+} FixedLengthCommands[] =
+{
+	{ concmd_ai, 2 }, { concmd_addstrength, 2 }, { concmd_strength, 2 }, { concmd_smacksprite, 1 }, { concmd_fakebubba, 1 },
+	{ concmd_rndmove, 1 }, { concmd_mamatrigger, 1 }, { concmd_mamaspawn, 1 }, { concmd_mamaquake, 1 }, { concmd_garybanjo, 1 },
+	{ concmd_motoloopsnd, 1 }, { concmd_getlastpal, 1 }, { concmd_tossweapon, 1 }, { concmd_mikesnd, 1 }, { concmd_pkick, 1 },
+	{ concmd_sizeat, 3 }, { concmd_shoot, 2 }, { concmd_soundtag, 1 }, { concmd_soundtagonce, 1 }, { concmd_soundonce, 2 },
+	{ concmd_stopsound, 2 }, { concmd_globalsound, 2 }, { concmd_smackbubba, 1 }, { concmd_mamaend, 1 }, { concmd_sound, 2 },
+	{ concmd_tip, 1 }, { concmd_tearitup, 1 }, { concmd_fall, 1 }, { concmd_addammo, 3 }, { concmd_money, 2 },
+	{ concmd_mail, 2 }, { concmd_sleeptime, 2 }, { concmd_paper, 2 }, { concmd_addkills, 2 }, { concmd_lotsofglass, 2 },
+	{ concmd_killit, 1 }, { concmd_addweapon, 3 }, { concmd_debug, 2 }, { concmd_endofgame, 2 }, { concmd_isdrunk, 2 },
+	{ concmd_strafeleft, 1 }, { concmd_straferight, 1 }, { concmd_larrybird, 1 }, { concmd_destroyit, 1 }, { concmd_move, 3 },
+	{ concmd_spawn, 2 }, { concmd_debris, 3 }, { concmd_cstator, 2 }, { concmd_clipdist, 2 }, { concmd_cstat, 2 },
+	{ concmd_newpic, 2 }, { concmd_resetplayer, 1 }, { concmd_addinventory, 3 }, { concmd_hitradius, 6 }, { concmd_guts, 3 },
+	{ concmd_slapplayer, 1 }, { concmd_wackplayer, 1 }, { concmd_operate, 1 }, { concmd_spritepal, 2 }, { concmd_cactor, 2 },
+	{ concmd_addlog, 3 }, { concmd_setvar, 3 }, { concmd_setvarvar, 3 }, { concmd_addvar, 3 }, { concmd_addvarvar, 3 },
+	{ concmd_pstomp, 1 }, { concmd_quote, 2 }, { concmd_respawnhitag, 1 }, { concmd_espawnvar, 2 }, { concmd_espawn, 2 },
+	{ concmd_setsector, 5 }, { concmd_getsector, 5 }, { concmd_sqrt, 3 }, { concmd_findnearactor, 4 }, { concmd_findnearactorvar, 4 },
+	{ concmd_setplayer, 5 }, { concmd_getplayer, 5 }, { concmd_getuserdef, 4 }, { concmd_setuserdef, 4 }, { concmd_setwall, 5 },
+	{ concmd_getwall, 5 }, { concmd_setactorvar, 4 }, { concmd_getactorvar, 4 }, { concmd_setactor, 5 }, { concmd_getactor, 5 },
+	{ concmd_getangletotarget, 2 }, { concmd_lockplayer, 2 }, { concmd_getplayerangle, 2 }, { concmd_setplayerangle, 2 }, { concmd_getactorangle, 2 },
+	{ concmd_setactorangle, 2 }, { concmd_randvar, 3 }, { concmd_mulvar, 3 }, { concmd_divvar, 3 }, { concmd_modvar, 3 },
+	{ concmd_andvar, 3 }, { concmd_xorvar, 3 }, { concmd_orvar, 3 }, { concmd_randvarvar, 3 }, { concmd_gmaxammo, 3 },
+	{ concmd_smaxammo, 3 }, { concmd_mulvarvar, 3 }, { concmd_divvarvar, 3 }, { concmd_modvarvar, 3 }, { concmd_andvarvar, 3 },
+	{ concmd_xorvarvar, 3 }, { concmd_orvarvar, 3 }, { concmd_subvar, 3 }, { concmd_subvarvar, 3 }, { concmd_sin, 3 },
+	{ concmd_spgetlotag, 1 }, { concmd_spgethitag, 1 }, { concmd_sectgetlotag, 1 }, { concmd_sectgethitag, 1 }, { concmd_gettexturefloor, 1 },
+	{ concmd_startlevel, 3 }, { concmd_displayrand, 2 }, { concmd_starttrack, 2 }, { concmd_gettextureceiling, 1 },
+};
+
+static int CommandLength(int op)
+{
+	for (auto& c : FixedLengthCommands)
+	{
+		if (c.op == op) return c.length;
+	}
+	return 0;
+}
+
+//---------------------------------------------------------------------------
+//
+//
+//
+//---------------------------------------------------------------------------
+
+void ConCodeCompiler::Compile(int address)
+{
+	int done = e->NewLabel();
+	EmitList(address, done);
+	e->Bind(done);
+	e->Return();
+}
+
+//---------------------------------------------------------------------------
+//
+// Equivalent of 'while (!parse());'. Returns the address behind the closing
+// brace if the list ends with one, -1 otherwise.
+//
+//---------------------------------------------------------------------------
+
+int ConCodeCompiler::EmitList(int pc, int done)
+{
+	int outerdeopt = deopt;
+	deopt = e->NewLabel();
+
+	int end = -1;
+	while (true)
+	{
+		int next = EmitStatement(pc, done, true);
+		if (next == StmtEnd)
+		{
+			end = listEnd;
+			break;
+		}
+		if (next == StmtUnknown)
+		{
+			e->Jump(deopt);
+			break;
+		}
+		pc = next;
+	}
+
+	e->Bind(deopt);
+	e->InterpretList();
+	e->Jump(done);
+
+	deopt = outerdeopt;
+	return end;
+}
+
+//---------------------------------------------------------------------------
+//
+// Equivalent of one parse() call. Inside a list the return value of parse()
+// ends the list by jumping to 'exit', otherwise it is ignored, just like
+// parseifelse() does.
+// On entry, insptr always points to 'pc'.
+//
+//---------------------------------------------------------------------------
+
+int ConCodeCompiler::EmitStatement(int pc, int exit, bool inlist)
+{
+	if (!ValidRange(pc, 1) || ++numStatements > MaxStatements)
+		return EmitInterpret(pc, exit, inlist, 0);
+
+	e->KillitCheck(exit);
+
+	int op = ScriptCode[pc];
+	switch (op)
+	{
+	case concmd_rightbrace:
+	case concmd_endswitch:
+		e->SetInsptr(pc + 1);
+		e->Jump(exit);
+		listEnd = pc + 1;
+		return StmtEnd;
+
+	case concmd_enda:
+	case concmd_break:
+	case concmd_ends:
+	case concmd_endevent:
+		e->Jump(exit);
+		listEnd = -1;
+		return StmtEnd;
+
+	case concmd_else:
+	{
+		if (!ValidRange(pc, 2)) break;
+		int target = ScriptCode[pc + 1];
+		if (!ValidRange(target, 1)) break;
+		e->SetInsptr(target);
+		return target;
+	}
+
+	case concmd_leftbrace:
+	{
+		e->SetInsptr(pc + 1);
+		int nestedexit = e->NewLabel();
+		int end = EmitList(pc + 1, nestedexit);
+		e->Bind(nestedexit);
+		if (end < 0 || !inlist) return StmtUnknown;
+		e->Guard(end, deopt);
+		return end;
+	}
+
+	case concmd_state:
+	{
+		if (!ValidRange(pc, 2)) break;
+		int target = ScriptCode[pc + 1];
+		if (!ValidRange(target, 1)) break;
+		if (States.Find(target) == States.Size()) States.Push(target);
+		e->RunState(target);
+		e->SetInsptr(pc + 2);
+		return pc + 2;
+	}
+
+	case concmd_action:
+		if (!ValidRange(pc, 2)) break;
+		e->SetTemp(2, 0);
+		e->SetTemp(3, 0);
+		e->SetTemp(4, ScriptCode[pc + 1]);
+		e->SetInsptr(pc + 2);
+		return pc + 2;
+
+	case concmd_count:
+		if (!ValidRange(pc, 2)) break;
+		e->SetTemp(0, (short)ScriptCode[pc + 1]);
+		e->SetInsptr(pc + 2);
+		return pc + 2;
+
+	case concmd_resetcount:
+		e->SetTemp(0, 0);
+		e->SetInsptr(pc + 1);
+		return pc + 1;
+
+	case concmd_resetactioncount:
+		e->SetTemp(2, 0);
+		e->SetInsptr(pc + 1);
+		return pc + 1;
+
+	case concmd_nullop:
+		e->SetInsptr(pc + 1);
+		return pc + 1;
+
+	default:
+		if (auto cond = GetConCondition(op))
+			return EmitIf(pc, cond, exit, inlist);
+		break;
+	}
+	return EmitInterpret(pc, exit, inlist, CommandLength(op));
+}
+
+//---------------------------------------------------------------------------
+//
+// Lets the interpreter run one command. With a known length the translated
+// code continues behind it, otherwise the list is finished by the interpreter.
+//
+//---------------------------------------------------------------------------
+
+int ConCodeCompiler::EmitInterpret(int pc, int exit, bool inlist, int length)
+{
+	e->Interpret(inlist ? exit : -1);
+	if (!inlist || length <= 0) return StmtUnknown;
+	e->Guard(pc + length, deopt);
+	return pc + length;
+}
+
+//---------------------------------------------------------------------------
+//
+// Equivalent of an 'if' command followed by parseifelse().
+// The layout is: command, arguments, else pointer, then-branch.
+//
+//---------------------------------------------------------------------------
+
+int ConCodeCompiler::EmitIf(int pc, const ConCondition* cond, int exit, bool inlist)
+{
+	int numargs = cond->numargs;
+	if (!ValidRange(pc, numargs + 3))
+		return EmitInterpret(pc, exit, inlist, 0);
+
+	int elseptr = ScriptCode[pc + numargs + 1];
+	if (!ValidRange(elseptr, 1))
+		return EmitInterpret(pc, exit, inlist, 0);
+
+	// where the list continues after both branches.
+	bool haselse = ScriptCode[elseptr] == concmd_else && ValidRange(elseptr, 2);
+	int next = haselse ? ScriptCode[elseptr + 1] : elseptr;
+
+	if (cond->check == nullptr)
+	{
+		// Condition and branch are intertwined so the interpreter needs to run the entire thing.
+		e->Interpret(inlist ? exit : -1);
+		if (haselse) e->SkipElse(elseptr, next);
+		if (!inlist) return StmtUnknown;
+		e->Guard(next, deopt);
+		return next;
+	}
+
+	int isfalse = e->NewLabel();
+	int join = e->NewLabel();
+	e->Condition(pc, cond, isfalse);
+
+	int thendone = e->NewLabel();
+	e->SetInsptr(pc + numargs + 2);
+	EmitStatement(pc + numargs + 2, thendone, false);
+	e->Bind(thendone);
+	e->After(cond, 1);
+	// The then-branch ends on the 'else' command which the list would execute next.
+	// Skipping it here is not observable because nothing can happen in between.
+	if (haselse) e->SkipElse(elseptr, next);
+	if (inlist) e->Guard(next, deopt);
+	e->Jump(join);
+
+	e->Bind(isfalse);
+	if (haselse)
+	{
+		int elsedone = e->NewLabel();
+		e->SetInsptr(elseptr + 2);
+		EmitStatement(elseptr + 2, elsedone, false);
+		e->Bind(elsedone);
+		e->After(cond, 0);
+		if (inlist) e->Guard(next, deopt);
+	}
+	else
+	{
+		e->SetInsptr(elseptr);
+		e->After(cond, 0);
+	}
+	e->Bind(join);
+	return inlist ? next : StmtUnknown;
+}
+
+//---------------------------------------------------------------------------
+//
+// The pre-decoded form: each step carries its handler index and all operands
+// already resolved to pointers, so the threaded interpreter below never has to
+// look at the raw script words itself.
+//
+//---------------------------------------------------------------------------
+
+#define CON_DECODED_OPS \
+	xx(JUMP) xx(RETURN) xx(KILLITCHECK) xx(SETINSPTR) xx(GUARD) xx(SKIPELSE) xx(INTERPRET) xx(INTERPRETLIST) \
+	xx(RUNSTATE) xx(SETTEMP) xx(CONDITION) xx(TEMPEQ) xx(TEMPGE) xx(DISTLESS) xx(DISTGREATER) xx(AFTER)
+
+enum EConDecodedOp
+{
+#define xx(op) DOP_##op,
+	CON_DECODED_OPS
+#undef xx
+};
+
+struct ConOp
+{
+	int op;
+	int target;		// label while decoding, index of the jump target afterwards.
+	int index;
+	int value;
+	const int* addr;
+	const ConCondition* cond;
+};
+
+class ConDecodeEmitter : public ConCodeEmitter
+{
+public:
+	TArray<ConOp> Code;
+
+	int NewLabel() override
+	{
+		return Labels.Push(-1);
+	}
+
+	void Bind(int label) override
+	{
+		Labels[label] = Code.Size();
+	}
+
+	void Jump(int label) override { Emit(DOP_JUMP, label); }
+	void Return() override { Emit(DOP_RETURN); }
+	void KillitCheck(int exit) override { Emit(DOP_KILLITCHECK, exit); }
+	void SetInsptr(int pc) override { Emit(DOP_SETINSPTR, -1, 0, 0, ScriptCode.Data() + pc); }
+	void Guard(int pc, int deopt) override { Emit(DOP_GUARD, deopt, 0, 0, ScriptCode.Data() + pc); }
+	void SkipElse(int elseptr, int next) override { Emit(DOP_SKIPELSE, -1, 0, next, ScriptCode.Data() + elseptr); }
+	void Interpret(int exit) override { Emit(DOP_INTERPRET, exit); }
+	void InterpretList() override { Emit(DOP_INTERPRETLIST); }
+	void RunState(int address) override { Emit(DOP_RUNSTATE, -1, 0, address); }
+	void SetTemp(int index, int value) override { Emit(DOP_SETTEMP, -1, index, value); }
+
+	void Condition(int pc, const ConCondition* cond, int isfalse) override
+	{
+		// Simple comparisons get their own ops, as described by the condition table.
+		int arg = ScriptCode[pc + 1];
+		switch (cond->compare)
+		{
+		case CONCMP_TEMPEQ: Emit(DOP_TEMPEQ, isfalse, cond->index, arg); break;
+		case CONCMP_TEMPGE: Emit(DOP_TEMPGE, isfalse, cond->index, arg); break;
+		case CONCMP_DISTLESS: Emit(DOP_DISTLESS, isfalse, 0, arg); break;
+		case CONCMP_DISTGREATER: Emit(DOP_DISTGREATER, isfalse, 0, arg); break;
+		default: Emit(DOP_CONDITION, isfalse, 0, 0, ScriptCode.Data() + pc + 1, cond); break;
+		}
+	}
+
+	void After(const ConCondition* cond, int result) override
+	{
+		if (cond->after) Emit(DOP_AFTER, -1, 0, result, nullptr, cond);
+	}
+
+	void Link()
+	{
+		for (auto& op : Code)
+		{
+			if (op.target >= 0) op.target = Labels[op.target];
+		}
+	}
+
+private:
+	TArray<int> Labels;
+
+	void Emit(int op, int target = -1, int index = 0, int value = 0, const int* addr = nullptr, const ConCondition* cond = nullptr)
+	{
+		Code.Push({ op, target, index, value, addr, cond });
+	}
+};
+
+static FMemArena DecodedArena;
+static TMap<int, const ConOp*> DecodedLists;
+
+static const ConOp* GetDecodedList(int address, TArray<int>* states = nullptr)
+{
+	auto check = DecodedLists.CheckKey(address);
+	if (check) return *check;
+
+	ConDecodeEmitter emitter;
+	ConCodeCompiler compiler(&emitter);
+	compiler.Compile(address);
+	emitter.Link();
+	if (states) states->Append(compiler.States);
+
+	auto code = (ConOp*)DecodedArena.Alloc(emitter.Code.Size() * sizeof(ConOp));
+	memcpy(code, emitter.Code.Data(), emitter.Code.Size() * sizeof(ConOp));
+	DecodedLists.Insert(address, code);
+	return code;
+}
+
+//---------------------------------------------------------------------------
+//
+// Threaded interpreter for the pre-decoded form.
+//
+//---------------------------------------------------------------------------
+
+#if !defined(CON_COMPGOTO) && defined(__GNUC__)
+#define CON_COMPGOTO 1
+#endif
+
+#if CON_COMPGOTO
+#define DOP(x)		op_##x
+#define NEXTDOP		{ ip++; goto *ops[ip->op]; }
+#define JUMPDOP(t)	{ ip = code + (t); goto *ops[ip->op]; }
+#else
+#define DOP(x)		case DOP_##x
+#define NEXTDOP		{ ip++; continue; }
+#define JUMPDOP(t)	{ ip = code + (t); continue; }
+#endif
+
+static void RunDecoded(ParseState& s, const ConOp* code)
+{
+#if CON_COMPGOTO
+	static void* const ops[] =
+	{
+#define xx(op) &&op_##op,
+		CON_DECODED_OPS
+#undef xx
+	};
+#endif
+	const ConOp* ip = code;
+
+#if CON_COMPGOTO
+	goto *ops[ip->op];
+#else
+	for (;;) switch (ip->op)
+#endif
+	{
+#if !CON_COMPGOTO
+	default:
+		assert(0 && "Undefined decoded CON op");
+		return;
+#endif
+	DOP(JUMP):
+		JUMPDOP(ip->target);
+
+	DOP(RETURN):
+		return;
+
+	DOP(KILLITCHECK):
+		if (s.killit_flag) JUMPDOP(ip->target);
+		NEXTDOP;
+
+	DOP(SETINSPTR):
+		s.insptr = const_cast<int*>(ip->addr);
+		NEXTDOP;
+
+	DOP(GUARD):
+		if (s.insptr != ip->addr) JUMPDOP(ip->target);
+		NEXTDOP;
+
+	DOP(SKIPELSE):
+		if (s.insptr == ip->addr) s.insptr = &ScriptCode[ip->value];
+		NEXTDOP;
+
+	DOP(INTERPRET):
+		if (s.parse() && ip->target >= 0) JUMPDOP(ip->target);
+		NEXTDOP;
+
+	DOP(INTERPRETLIST):
+		while (1) if (s.parse()) break;
+		NEXTDOP;
+
+	DOP(RUNSTATE):
+	{
+		s.insptr = &ScriptCode[ip->value];
+		RunDecoded(s, GetDecodedList(ip->value));
+		NEXTDOP;
+	}
+
+	DOP(SETTEMP):
+		s.g_t[ip->index] = ip->value;
+		NEXTDOP;
+
+	DOP(CONDITION):
+		if (!ip->cond->check(&s, ip->addr)) JUMPDOP(ip->target);
+		NEXTDOP;
+
+	DOP(TEMPEQ):
+		if (s.g_t[ip->index] != ip->value) JUMPDOP(ip->target);
+		NEXTDOP;
+
+	DOP(TEMPGE):
+		if (s.g_t[ip->index] < ip->value) JUMPDOP(ip->target);
+		NEXTDOP;
+
+	DOP(DISTLESS):
+		if (!(s.g_x < ip->value)) JUMPDOP(ip->target);
+		NEXTDOP;
+
+	DOP(DISTGREATER):
+		if (!(s.g_x > ip->value)) JUMPDOP(ip->target);
+		NEXTDOP;
+
+	DOP(AFTER):
+		ip->cond->after(&s, ip->value);
+		NEXTDOP;
+	}
+}
+
+#undef DOP
+#undef NEXTDOP
+#undef JUMPDOP
+
+//---------------------------------------------------------------------------
+//
+// Runs the list at s.insptr with the given engine.
+//
+//---------------------------------------------------------------------------
+
+static void RunWithEngine(ParseState& s, int engine)
+{
+	int address = int(s.insptr - ScriptCode.Data());
+	if (engine == CONENGINE_NATIVE)
+	{
+		auto func = ConJit_Get(address);
+		if (func)
+		{
+			func(&s);
+			return;
+		}
+	}
+	else if (engine == CONENGINE_DECODED)
+	{
+		RunDecoded(s, GetDecodedList(address));
+		return;
+	}
+	while (!s.parse());
+}
+
+//---------------------------------------------------------------------------
+//
+// Translates all actors, events and the states they use for the given engine.
+//
+//---------------------------------------------------------------------------
+
+static unsigned TranslateAll(int engine)
+{
+	if (engine == CONENGINE_INTERPRETER) return 0;
+
+	TArray<int> pending;
+	for (int i = 0; i < MAXTILES; i++)
+	{
+		if (gs.actorinfo[i].scriptaddress) pending.Push(4 + gs.actorinfo[i].scriptaddress);
+	}
+	for (int i = 0; i < MAXGAMEEVENTS; i++)
+	{
+		if (apScriptGameEvent[i]) pending.Push((int)apScriptGameEvent[i]);
+	}
+
+	TArray<int> done;
+	int address;
+	while (pending.Pop(address))
+	{
+		if (done.Find(address) < done.Size()) continue;
+		done.Push(address);
+		if (engine == CONENGINE_NATIVE) ConJit_Get(address, &pending);
+		else GetDecodedList(address, &pending);
+	}
+	return done.Size();
+}
+
+//---------------------------------------------------------------------------
+//
+// conbench: alternates the engines from one tic to the next and compares
+// how long they take for the same game.
+//
+//---------------------------------------------------------------------------
+
+struct ConBenchStats
+{
+	uint64_t time;
+	uint64_t runs;
+};
+
+static ConBenchStats conBench[NUM_CONENGINES];
+static int conBenchTics;
+static int conBenchStart;
+static int conBenchDepth;
+
+static void ConBench_Report()
+{
+	Printf("CON engine benchmark over %d tics:\n", conBenchTics);
+	static const char* names[] = { "interpreter", "decoded", "native" };
+	double base = 0;
+	for (int i = 0; i < NUM_CONENGINES; i++)
+	{
+		auto& b = conBench[i];
+		if (b.runs == 0) continue;
+		double perrun = double(b.time) / b.runs;
+		if (i == CONENGINE_INTERPRETER) base = perrun;
+		Printf("%-12s %9llu runs %9.2f ms %8.1f ns/run %10.0f runs/s", names[i], (unsigned long long)b.runs, b.time / 1000000., perrun, 1e9 / perrun);
+		if (base > 0 && i != CONENGINE_INTERPRETER) Printf(" %5.2fx", base / perrun);
+		Printf("\n");
+	}
+}
+
+CCMD(conbench)
+{
+	if (gamestate != GS_LEVEL)
+	{
+		Printf("conbench: must be in a level\n");
+		return;
+	}
+	// Everything is translated up front so that no engine gets its translation time measured.
+	TranslateAll(CONENGINE_DECODED);
+#ifdef HAVE_VM_JIT
+	TranslateAll(CONENGINE_NATIVE);
+#endif
+	conBenchTics = argv.argc() > 1 ? max(atoi(argv[1]), 2) : 1050;
+	conBenchStart = everyothertime;
+	memset(conBench, 0, sizeof(conBench));
+	Printf("Running CON engine benchmark for %d tics\n", conBenchTics);
+}
+
+//---------------------------------------------------------------------------
+//
+// Runs the list at s.insptr, i.e. 'while (!s.parse());' with the engine
+// selected by con_engine.
+//
+//---------------------------------------------------------------------------
+
+void ConCode_Run(ParseState& s)
+{
+	if (conBenchTics == 0 || conBenchDepth > 0)
+	{
+		RunWithEngine(s, con_engine);
+		return;
+	}
+
+	int tic = everyothertime - conBenchStart;
+	if (tic >= conBenchTics)
+	{
+		ConBench_Report();
+		conBenchTics = 0;
+		RunWithEngine(s, con_engine);
+		return;
+	}
+
+#ifdef HAVE_VM_JIT
+	int engine = tic % NUM_CONENGINES;
+#else
+	int engine = tic % CONENGINE_NATIVE;
+#endif
+	// Code that is not reached from an actor or event still gets translated on first use, which must not be timed either.
+	int address = int(s.insptr - ScriptCode.Data());
+	if (engine == CONENGINE_NATIVE) ConJit_Get(address);
+	else if (engine == CONENGINE_DECODED) GetDecodedList(address);
+
+	conBenchDepth++;
+	auto start = I_nsTime();
+	RunWithEngine(s, engine);
+	conBench[engine].time += I_nsTime() - start;
+	conBench[engine].runs++;
+	conBenchDepth--;
+}
+
+//---------------------------------------------------------------------------
+//
+// Called after the CONs have been compiled. Translates all actors, events
+// and the states they use in advance so that there are no hitches during play.
+//
+//---------------------------------------------------------------------------
+
+void ConCode_Init()
+{
+	DecodedLists.Clear();
+	DecodedArena.FreeAll();
+	ConJit_Clear();
+	if (con_engine == CONENGINE_INTERPRETER) return;
+
+	auto before = I_nsTime();
+	unsigned count = TranslateAll(con_engine);
+	DPrintf(DMSG_NOTIFY, "Translated %u CON code blocks in %.2f ms\n", count, (I_nsTime() - before) / 1000000.);
+}
+
+END_DUKE_NS
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "gameexec.h"
+
+BEGIN_DUKE_NS
+
+enum EConEngine
+{
+	CONENGINE_INTERPRETER,	// ParseState::parse
+	CONENGINE_DECODED,		// pre-decoded, threaded code
+	CONENGINE_NATIVE,		// asmjit generated machine code
+
+	NUM_CONENGINES
+};
+
+//---------------------------------------------------------------------------
+//
+// Back end for translating CON statement lists into another form.
+// Labels are indices handed out by NewLabel.
+//
+//---------------------------------------------------------------------------
+
+class ConCodeEmitter
+{
+public:
+	virtual ~ConCodeEmitter() = default;
+
+	virtual int NewLabel() = 0;
+	virtual void Bind(int label) = 0;
+	virtual void Jump(int label) = 0;
+	virtual void Return() = 0;
+
+	virtual void KillitCheck(int exit) = 0;			// jumps to 'exit' if killit_flag is set.
+	virtual void SetInsptr(int pc) = 0;
+	virtual void Guard(int pc, int deopt) = 0;		// jumps to 'deopt' if insptr does not point to 'pc'.
+	virtual void SkipElse(int elseptr, int next) = 0;	// sets insptr to 'next' if it points to 'elseptr'.
+	virtual void Interpret(int exit) = 0;			// one parse() call, jumps to 'exit' if it returns non-zero and 'exit' is not -1.
+	virtual void InterpretList() = 0;				// while (!parse());
+	virtual void RunState(int address) = 0;
+	virtual void SetTemp(int index, int value) = 0;	// g_t[index] = value;
+	virtual void Condition(int pc, const ConCondition* cond, int isfalse) = 0;	// jumps to 'isfalse' if the condition of the 'if' command at 'pc' fails.
+	virtual void After(const ConCondition* cond, int result) = 0;
+};
+
+//---------------------------------------------------------------------------
+//
+// Breaks a statement list into simple steps. Everything it cannot
+// handle is left to the interpreter, with guards that hand the rest of
+// the list to parse() if insptr does not end up where it was expected.
+//
+//---------------------------------------------------------------------------
+
+class ConCodeCompiler
+{
+public:
+	ConCodeCompiler(ConCodeEmitter* emitter) : e(emitter) { }
+
+	void Compile(int address);
+
+	TArray<int> States;	// all states the list calls.
+
+private:
+	enum
+	{
+		StmtEnd = -1,		// the statement ended the list.
+		StmtUnknown = -2,	// the statement continues at a location only known at run time.
+		MaxStatements = 4096
+	};
+
+	int EmitList(int pc, int done);
+	int EmitStatement(int pc, int exit, bool inlist);
+	int EmitInterpret(int pc, int exit, bool inlist, int length);
+	int EmitIf(int pc, const ConCondition* cond, int exit, bool inlist);
+
+	bool ValidRange(int pc, int count) const
+	{
+		return pc > 0 && pc + count <= (int)ScriptCode.Size();
+	}
+
+	ConCodeEmitter* e;
+	int deopt = -1;		// runs the rest of the current list through the interpreter.
+	int listEnd = -1;	// insptr after the last '}'.
+	int numStatements = 0;
+};
+
+// conjit.cpp
+using ConJitFunc = void(*)(ParseState*);
+ConJitFunc ConJit_Get(int address, TArray<int>* states = nullptr);
+void ConJit_Clear();
+
+END_DUKE_NS
@@ -0,0 +1,377 @@
+//-------------------------------------------------------------------------
+/*
+Copyright (C) 2021 - Raze developers
+
+This file is part of Raze.
+
+Raze is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+//-------------------------------------------------------------------------
+
+// Native code back end for the CON translator in condecode.cpp, using the same
+// asmjit setup as the ZScript JIT.
+
+#include "ns.h"
+#include "concmd.h"
+#include "duke3d.h"
+#include "gamevar.h"
+#include "condecode.h"
+#include "printf.h"
+
+#ifdef HAVE_VM_JIT
+#define ASMJIT_BUILD_EMBED
+#define ASMJIT_STATIC
+#include <asmjit/asmjit.h>
+#include <asmjit/x86.h>
+#include "jit.h"
+#endif
+
+BEGIN_DUKE_NS
+
+#ifdef HAVE_VM_JIT
+
+static TMap<int, ConJitFunc> ConJitLists;	// a null entry means the list could not be compiled.
+
+//---------------------------------------------------------------------------
+//
+// Functions called by the generated code
+//
+//---------------------------------------------------------------------------
+
+static int Interpret(ParseState* s)
+{
+	return s->parse();
+}
+
+static void InterpretList(ParseState* s)
+{
+	while (!s->parse());
+}
+
+static void RunState(ParseState* s, int address)
+{
+	s->insptr = &ScriptCode[address];
+	auto func = ConJit_Get(address);
+	if (func) func(s);
+	else InterpretList(s);
+}
+
+//---------------------------------------------------------------------------
+//
+//
+//
+//---------------------------------------------------------------------------
+
+class ConJitErrorHandler : public asmjit::ErrorHandler
+{
+public:
+	bool handleError(asmjit::Error err, const char *message, asmjit::CodeEmitter *origin) override
+	{
+		throw CRecoverableError(message);
+	}
+};
+
+class ConJitEmitter : public ConCodeEmitter
+{
+public:
+	ConJitEmitter(asmjit::CodeHolder *code) : cc(code) { }
+
+	asmjit::CCFunc *Begin();
+	void End();
+
+	int NewLabel() override;
+	void Bind(int label) override;
+	void Jump(int label) override;
+	void Return() override;
+	void KillitCheck(int exit) override;
+	void SetInsptr(int pc) override;
+	void Guard(int pc, int deopt) override;
+	void SkipElse(int elseptr, int next) override;
+	void Interpret(int exit) override;
+	void InterpretList() override;
+	void RunState(int address) override;
+	void SetTemp(int index, int value) override;
+	void Condition(int pc, const ConCondition *cond, int isfalse) override;
+	void After(const ConCondition *cond, int result) override;
+
+private:
+	void CompareInsptr(int pc);
+	asmjit::X86Gp LoadTempPointer();
+
+	template<typename RetType, typename P1>
+	asmjit::CCFuncCall *CreateCall(RetType(*func)(P1 p1)) { return cc.call(asmjit::imm_ptr(reinterpret_cast<void*>(func)), asmjit::FuncSignature1<RetType, P1>()); }
+
+	template<typename RetType, typename P1, typename P2>
+	asmjit::CCFuncCall *CreateCall(RetType(*func)(P1 p1, P2 p2)) { return cc.call(asmjit::imm_ptr(reinterpret_cast<void*>(func)), asmjit::FuncSignature2<RetType, P1, P2>()); }
+
+	asmjit::X86Compiler cc;
+	asmjit::X86Gp state;
+	TArray<asmjit::Label> labels;
+};
+
+//---------------------------------------------------------------------------
+//
+//
+//
+//---------------------------------------------------------------------------
+
+asmjit::CCFunc *ConJitEmitter::Begin()
+{
+	using namespace asmjit;
+
+	auto func = cc.addFunc(FuncSignature1<void, ParseState*>());
+	state = cc.newIntPtr("state");
+	cc.setArg(0, state);
+	return func;
+}
+
+void ConJitEmitter::End()
+{
+	cc.endFunc();
+	cc.finalize();
+}
+
+int ConJitEmitter::NewLabel()
+{
+	return labels.Push(cc.newLabel());
+}
+
+void ConJitEmitter::Bind(int label)
+{
+	cc.bind(labels[label]);
+}
+
+void ConJitEmitter::Jump(int label)
+{
+	cc.jmp(labels[label]);
+}
+
+void ConJitEmitter::Return()
+{
+	cc.ret();
+}
+
+void ConJitEmitter::KillitCheck(int exit)
+{
+	using namespace asmjit;
+
+	cc.cmp(x86::byte_ptr(state, offsetof(ParseState, killit_flag)), imm(0));
+	cc.jne(labels[exit]);
+}
+
+void ConJitEmitter::SetInsptr(int pc)
+{
+	using namespace asmjit;
+
+	auto ptr = cc.newIntPtr("insptr");
+	cc.mov(ptr, imm_ptr(ScriptCode.Data() + pc));
+	cc.mov(x86::ptr(state, offsetof(ParseState, insptr)), ptr);
+}
+
+void ConJitEmitter::CompareInsptr(int pc)
+{
+	using namespace asmjit;
+
+	auto cur = cc.newIntPtr("insptr");
+	auto expected = cc.newIntPtr("expected");
+	cc.mov(cur, x86::ptr(state, offsetof(ParseState, insptr)));
+	cc.mov(expected, imm_ptr(ScriptCode.Data() + pc));
+	cc.cmp(cur, expected);
+}
+
+void ConJitEmitter::Guard(int pc, int deopt)
+{
+	CompareInsptr(pc);
+	cc.jne(labels[deopt]);
+}
+
+void ConJitEmitter::SkipElse(int elseptr, int next)
+{
+	auto skip = cc.newLabel();
+	CompareInsptr(elseptr);
+	cc.jne(skip);
+	SetInsptr(next);
+	cc.bind(skip);
+}
+
+void ConJitEmitter::Interpret(int exit)
+{
+	auto result = cc.newInt32("result");
+	auto call = CreateCall(Duke3d::Interpret);
+	call->setArg(0, state);
+	call->setRet(0, result);
+	if (exit >= 0)
+	{
+		cc.test(result, result);
+		cc.jnz(labels[exit]);
+	}
+}
+
+void ConJitEmitter::InterpretList()
+{
+	CreateCall(Duke3d::InterpretList)->setArg(0, state);
+}
+
+void ConJitEmitter::RunState(int address)
+{
+	auto call = CreateCall(Duke3d::RunState);
+	call->setArg(0, state);
+	call->setArg(1, asmjit::imm(address));
+}
+
+void ConJitEmitter::SetTemp(int index, int value)
+{
+	using namespace asmjit;
+
+	cc.mov(x86::dword_ptr(LoadTempPointer(), index * sizeof(int)), imm(value));
+}
+
+asmjit::X86Gp ConJitEmitter::LoadTempPointer()
+{
+	using namespace asmjit;
+
+	auto t = cc.newIntPtr("g_t");
+	cc.mov(t, x86::ptr(state, offsetof(ParseState, g_t)));
+	return t;
+}
+
+//---------------------------------------------------------------------------
+//
+// Conditions that the table describes as a simple comparison are generated
+// inline, all others call the table's check function.
+//
+//---------------------------------------------------------------------------
+
+void ConJitEmitter::Condition(int pc, const ConCondition *cond, int isfalse)
+{
+	using namespace asmjit;
+
+	auto label = labels[isfalse];
+	int arg = ScriptCode[pc + 1];
+	switch (cond->compare)
+	{
+	case CONCMP_TEMPEQ:
+		cc.cmp(x86::dword_ptr(LoadTempPointer(), cond->index * sizeof(int)), imm(arg));
+		cc.jne(label);
+		break;
+
+	case CONCMP_TEMPGE:
+		cc.cmp(x86::dword_ptr(LoadTempPointer(), cond->index * sizeof(int)), imm(arg));
+		cc.jl(label);
+		break;
+
+	case CONCMP_DISTLESS:
+		cc.cmp(x86::dword_ptr(state, offsetof(ParseState, g_x)), imm(arg));
+		cc.jge(label);
+		break;
+
+	case CONCMP_DISTGREATER:
+		cc.cmp(x86::dword_ptr(state, offsetof(ParseState, g_x)), imm(arg));
+		cc.jle(label);
+		break;
+
+	default:
+	{
+		auto result = cc.newInt32("result");
+		auto call = CreateCall(cond->check);
+		call->setArg(0, state);
+		call->setArg(1, imm_ptr(&ScriptCode[pc + 1]));
+		call->setRet(0, result);
+		cc.test(result, result);
+		cc.jz(label);
+		break;
+	}
+	}
+}
+
+void ConJitEmitter::After(const ConCondition *cond, int result)
+{
+	if (cond->after)
+	{
+		auto call = CreateCall(cond->after);
+		call->setArg(0, state);
+		call->setArg(1, asmjit::imm(result));
+	}
+}
+
+//---------------------------------------------------------------------------
+//
+//
+//
+//---------------------------------------------------------------------------
+
+static ConJitFunc CompileList(int address, TArray<int> *states)
+{
+	using namespace asmjit;
+
+	try
+	{
+		ConJitErrorHandler errorHandler;
+		CodeHolder code;
+		code.init(GetHostCodeInfo());
+		code.setErrorHandler(&errorHandler);
+
+		ConJitEmitter emitter(&code);
+		ConCodeCompiler compiler(&emitter);
+		auto func = emitter.Begin();
+		compiler.Compile(address);
+		emitter.End();
+		if (states) states->Append(compiler.States);
+		return reinterpret_cast<ConJitFunc>(AddJitFunction(&code, func, FStringf("CON code at %d", address), "CON"));
+	}
+	catch (const CRecoverableError &e)
+	{
+		Printf("CON code at %d: Unexpected JIT error: %s\n", address, e.what());
+		return nullptr;
+	}
+}
+
+//---------------------------------------------------------------------------
+//
+// Returns the native code for the list at 'address', or null if it cannot
+// be compiled. The machine code is only freed when the JIT releases all its memory.
+//
+//---------------------------------------------------------------------------
+
+ConJitFunc ConJit_Get(int address, TArray<int> *states)
+{
+	auto check = ConJitLists.CheckKey(address);
+	if (check) return *check;
+
+	auto func = CompileList(address, states);
+	ConJitLists.Insert(address, func);
+	return func;
+}
+
+void ConJit_Clear()
+{
+	ConJitLists.Clear();
+}
+
+#else
+
+ConJitFunc ConJit_Get(int address, TArray<int> *states)
+{
+	return nullptr;
+}
+
+void ConJit_Clear()
+{
+}
+
+#endif
+
+END_DUKE_NS
@@ -0,0 +1,215 @@
+//-------------------------------------------------------------------------
+/*
+Copyright (C) 2021 - Raze developers
+
+This file is part of Raze.
+
+Raze is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+//-------------------------------------------------------------------------
+
+// CON profiler: attributes executed commands and time to actor scripts,
+// eventloadactor scripts, events and states.
+//
+// While it is off nothing gets measured. The game code only tests
+// conProfiling before running a script. Profiled scripts run through
+// parseprofiled(), which is the only place where commands get counted.
+
+#include "ns.h"
+#include "duke3d.h"
+#include "gamevar.h"
+#include "gameexec.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "i_time.h"
+#include "files.h"
+
+BEGIN_DUKE_NS
+
+const char* getstatelabel(int address);
+
+bool conProfiling;
+uint64_t conProfileInstructions;
+
+struct ConProfileEntry
+{
+	int kind;
+	int id;
+	uint64_t calls;
+	uint64_t instructions;		// including called states
+	uint64_t selfInstructions;
+	uint64_t time;				// in ns, including called states
+	uint64_t selfTime;
+};
+
+struct ConProfileFrame
+{
+	uint64_t start;
+	uint64_t startInstructions;
+	uint64_t childTime;
+	uint64_t childInstructions;
+};
+
+static TMap<int, ConProfileEntry> conProfile[NUM_CONPROFILE];
+static TArray<ConProfileFrame> conProfileStack;
+static uint64_t conProfileStart, conProfileEnd;
+
+static const char* const kindNames[] = { "actor", "loadactor", "event", "state" };
+
+//---------------------------------------------------------------------------
+//
+// Runs the list at s.insptr through the interpreter and accounts for it.
+// The other CON engines are bypassed because they run states without
+// going through parse().
+//
+//---------------------------------------------------------------------------
+
+void ConProfile_Run(ParseState& s, int kind, int id)
+{
+	conProfileStack.Push({ I_nsTime(), conProfileInstructions, 0, 0 });
+
+	while (!s.parseprofiled());
+
+	ConProfileFrame frame;
+	conProfileStack.Pop(frame);
+	uint64_t time = I_nsTime() - frame.start;
+	uint64_t instructions = conProfileInstructions - frame.startInstructions;
+
+	auto& entry = conProfile[kind][id];
+	entry.kind = kind;
+	entry.id = id;
+	entry.calls++;
+	entry.time += time;
+	entry.selfTime += time - frame.childTime;
+	entry.instructions += instructions;
+	entry.selfInstructions += instructions - frame.childInstructions;
+
+	if (conProfileStack.Size() > 0)
+	{
+		auto& parent = conProfileStack.Last();
+		parent.childTime += time;
+		parent.childInstructions += instructions;
+	}
+}
+
+//---------------------------------------------------------------------------
+//
+//
+//
+//---------------------------------------------------------------------------
+
+static FString EntryName(const ConProfileEntry& entry)
+{
+	if (entry.kind == CONPROFILE_STATE)
+	{
+		auto name = getstatelabel(entry.id);
+		if (name) return name;
+	}
+	return FStringf("%d", entry.id);
+}
+
+static TArray<ConProfileEntry*> SortedEntries()
+{
+	TArray<ConProfileEntry*> list;
+	for (auto& map : conProfile)
+	{
+		TMap<int, ConProfileEntry>::Iterator it(map);
+		TMap<int, ConProfileEntry>::Pair* pair;
+		while (it.NextPair(pair)) list.Push(&pair->Value);
+	}
+	std::sort(list.begin(), list.end(), [](const ConProfileEntry* a, const ConProfileEntry* b)
+	{
+		return a->selfTime > b->selfTime;
+	});
+	return list;
+}
+
+static void ConProfile_Print(int count)
+{
+	double total = double((conProfiling ? I_nsTime() : conProfileEnd) - conProfileStart);
+	auto list = SortedEntries();
+	Printf("%-10s %-24s %9s %12s %12s %10s %10s\n", "type", "name", "calls", "commands", "self cmds", "ms", "self ms");
+	for (unsigned i = 0; i < list.Size() && (int)i < count; i++)
+	{
+		auto e = list[i];
+		Printf("%-10s %-24s %9llu %12llu %12llu %10.3f %10.3f\n", kindNames[e->kind], EntryName(*e).GetChars(),
+			(unsigned long long)e->calls, (unsigned long long)e->instructions, (unsigned long long)e->selfInstructions, e->time / 1e6, e->selfTime / 1e6);
+	}
+	if (total > 0) Printf("%u entries, %llu commands in %.2f s\n", list.Size(), (unsigned long long)conProfileInstructions, total / 1e9);
+}
+
+static void ConProfile_WriteCSV(const char* filename)
+{
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(filename));
+	if (!fw)
+	{
+		Printf("Unable to write %s\n", filename);
+		return;
+	}
+	fw->Printf("type,id,name,calls,commands,self commands,time ns,self time ns\n");
+	for (auto e : SortedEntries())
+	{
+		fw->Printf("%s,%d,%s,%llu,%llu,%llu,%llu,%llu\n", kindNames[e->kind], e->id, EntryName(*e).GetChars(), (unsigned long long)e->calls,
+			(unsigned long long)e->instructions, (unsigned long long)e->selfInstructions, (unsigned long long)e->time, (unsigned long long)e->selfTime);
+	}
+	Printf("CON profile written to %s\n", filename);
+}
+
+static void ConProfile_Reset()
+{
+	for (auto& map : conProfile) map.Clear();
+	conProfileInstructions = 0;
+	conProfileStart = conProfileEnd = I_nsTime();
+}
+
+//---------------------------------------------------------------------------
+//
+// conprofile start|stop|reset
+// conprofile [count]: lists the entries with the highest self time.
+// conprofile csv <file>
+//
+//---------------------------------------------------------------------------
+
+CCMD(conprofile)
+{
+	if (argv.argc() > 1 && !stricmp(argv[1], "start"))
+	{
+		ConProfile_Reset();
+		conProfiling = true;
+		Printf("CON profiler started\n");
+	}
+	else if (argv.argc() > 1 && !stricmp(argv[1], "stop"))
+	{
+		if (conProfiling) conProfileEnd = I_nsTime();
+		conProfiling = false;
+		Printf("CON profiler stopped\n");
+	}
+	else if (argv.argc() > 1 && !stricmp(argv[1], "reset"))
+	{
+		ConProfile_Reset();
+	}
+	else if (argv.argc() > 1 && !stricmp(argv[1], "csv"))
+	{
+		if (argv.argc() < 3) Printf("Usage: conprofile csv <filename>\n");
+		else ConProfile_WriteCSV(argv[2]);
+	}
+	else
+	{
+		ConProfile_Print(argv.argc() > 1 ? atoi(argv[1]) : 20);
+	}
+}
+
+END_DUKE_NS
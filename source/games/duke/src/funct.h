@@ -226,6 +226,7 @@ int playercolor2lookup(int color);
 void PlayerColorChanged(void);
 bool movementBlocked(player_struct *p);
 void loadcons();
+void ConCode_Init();
 void recordoldspritepos();
 void DrawStatusBar();
 
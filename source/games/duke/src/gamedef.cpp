@@ -381,6 +381,16 @@ int getlabelvalue(const char* text)
 	return lnum < 0 ? -1 : labels[lnum].value;
 }
 
+// For the CON profiler.
+const char* getstatelabel(int address)
+{
+	for (auto& label : labels)
+	{
+		if (label.type == LABEL_STATE && label.value == address) return label.GetChars();
+	}
+	return nullptr;
+}
+
 //---------------------------------------------------------------------------
 //
 // 
@@ -3249,6 +3259,7 @@ void loadcons()
 
 	// These can only be retrieved AFTER loading the scripts.
 	InitGameVarPointers();
+	ConCode_Init();
 	ResetSystemDefaults();
 	S_WorldTourMappingsForOldSounds(); // create a sound mapping for World Tour.
 	S_CacheAllSounds();
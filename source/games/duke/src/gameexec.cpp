@@ -40,6 +40,7 @@ source as it is released.
 #include "conlabel.h"
 #include "automap.h"
 #include "dukeactor.h"
+#include "gameexec.h"
 
 BEGIN_DUKE_NS
 
@@ -66,20 +67,6 @@ enum playeraction_t {
 
 
 
-struct ParseState
-{
-	int g_p;
-	int g_x;
-	int* g_t;
-	uint8_t killit_flag;
-	DDukeActor *g_ac;
-	int* insptr;
-	Collision coll;
-
-	int parse(void);
-	void parseifelse(int condition);
-};
-
 int furthestcanseepoint(DDukeActor* i, DDukeActor* ts, int* dax, int* day);
 bool ifsquished(DDukeActor* i, int p);
 void fakebubbaspawn(DDukeActor* actor, int g_p);
@@ -1356,13 +1343,14 @@ void DoActor(bool bSet, int lVar1, int lLabelID, int lVar2, DDukeActor* sActor,
 //
 //---------------------------------------------------------------------------
 
+template<bool profiled>
 void ParseState::parseifelse(int condition)
 {
 	if( condition )
 	{
 		// skip 'else' pointer.. and...
 		insptr+=2;
-		parse();
+		parsecmd<profiled>();
 	}
 	else
 	{
@@ -1373,7 +1361,7 @@ void ParseState::parseifelse(int condition)
 
 			// skip 'else' and...
 			insptr+=2;
-			parse();
+			parsecmd<profiled>();
 		}
 	}
 }
@@ -1493,66 +1481,294 @@ static bool ifcansee(DDukeActor* actor, int pnum)
 }
 
 
+//---------------------------------------------------------------------------
+//
+// The conditions of the 'if' commands, split off from the branch.
+// parse() evaluates these through parsecondition(), the native CON code
+// calls them directly.
+//
+//---------------------------------------------------------------------------
+
+static void sleepifseen(ParseState* s, int result)
+{
+	if (result) s->g_ac->timetosleep = SLEEPTIME;
+}
+
+static void sleepiffar(ParseState* s, int result)
+{
+	if (s->g_x > MAXSLEEPDIST && s->g_ac->timetosleep == 0)
+		s->g_ac->timetosleep = SLEEPTIME;
+}
+
+static int getgamevar(ParseState* s, int id)
+{
+	return GetGameVarID(id, s->g_ac, s->g_p);
+}
+
+// Conditions that consist of a single EConCompare. 'check' is derived from the same description that the translated code uses.
+template<int compare, int index = 0>
+static ConCondition comparecondition(void (*after)(ParseState* s, int result) = nullptr)
+{
+	static_assert(compare != CONCMP_NONE, "comparecondition needs a comparison");
+	auto check = [](ParseState* s, const int* a) -> int
+	{
+		switch (compare)
+		{
+		case CONCMP_TEMPEQ: return s->g_t[index] == a[0];
+		case CONCMP_TEMPGE: return s->g_t[index] >= a[0];
+		case CONCMP_DISTLESS: return s->g_x < a[0];
+		case CONCMP_DISTGREATER: return s->g_x > a[0];
+		}
+		return 0;
+	};
+	return { 1, check, after, compare, index };
+}
+
+static const struct
+{
+	int op;
+	ConCondition cond;
+} conditions[] =
+{
+	{ concmd_ifrnd, { 1, [](ParseState* s, const int* a) -> int
+		{
+			// HACK ALERT! The fire animation uses a broken ifrnd setup to delay its start because original CON has no variables.
+			// But the chosen random value of 16/255 is too low and can cause delays of a second or more.
+			if (s->g_ac->s->picnum == TILE_FIRE && s->g_t[4] == 0 && a[0] == 16) return rnd(64);
+			return rnd(a[0]);
+		} } },
+	{ concmd_ifcanshoottarget, { 0, [](ParseState* s, const int* a) -> int { return ifcanshoottarget(s->g_ac, s->g_p, s->g_x); } } },
+	{ concmd_ifcanseetarget, { 0, [](ParseState* s, const int* a) -> int
+		{
+			auto spr = s->g_ac->s;
+			auto p = &ps[s->g_p];
+			return cansee(spr->x, spr->y, spr->z - ((krand() & 41) << 8), spr->sectnum, p->posx, p->posy, p->posz, p->GetActor()->s->sectnum);
+		}, sleepifseen } },
+	{ concmd_ifnocover, { 0, [](ParseState* s, const int* a) -> int
+		{
+			auto spr = s->g_ac->s;
+			auto p = &ps[s->g_p];
+			return cansee(spr->x, spr->y, spr->z, spr->sectnum, p->posx, p->posy, p->posz, p->GetActor()->s->sectnum);
+		}, sleepifseen } },
+	{ concmd_ifactornotstayput, { 0, [](ParseState* s, const int* a) -> int { return s->g_ac->actorstayput == -1; } } },
+	{ concmd_ifcansee, { 0, [](ParseState* s, const int* a) -> int { return ifcansee(s->g_ac, s->g_p); } } },
+	{ concmd_ifhitweapon, { 0, [](ParseState* s, const int* a) -> int { return fi.ifhitbyweapon(s->g_ac) >= 0; } } },
+	{ concmd_ifsquished, { 0, [](ParseState* s, const int* a) -> int { return ifsquished(s->g_ac, s->g_p) == 1; } } },
+	{ concmd_ifdead, { 0, [](ParseState* s, const int* a) -> int
+		{
+			int j = s->g_ac->s->extra;
+			if (s->g_ac->s->picnum == TILE_APLAYER) j--;
+			return j < 0;
+		} } },
+	{ concmd_ifpdistl, comparecondition<CONCMP_DISTLESS>(sleepiffar) },
+	{ concmd_ifpdistg, comparecondition<CONCMP_DISTGREATER>(sleepiffar) },
+	{ concmd_ifgotweaponce, { 1 } },
+	{ concmd_ifsoundid, { 1, [](ParseState* s, const int* a) -> int { return (short)a[0] == ambientlotag[s->g_ac->s->ang]; } } },
+	{ concmd_ifsounddist, { 1 } },
+	{ concmd_ifactorhealthg, { 1, [](ParseState* s, const int* a) -> int { return s->g_ac->s->extra > (short)a[0]; } } },
+	{ concmd_ifactorhealthl, { 1, [](ParseState* s, const int* a) -> int { return s->g_ac->s->extra < (short)a[0]; } } },
+	{ concmd_iftipcow, { 0, [](ParseState* s, const int* a) -> int
+		{
+			if (s->g_ac->spriteextra != 1) return 0;
+			s->g_ac->spriteextra++;
+			return 1;
+		} } },
+	{ concmd_ifhittruck, { 0, [](ParseState* s, const int* a) -> int
+		{
+			if (s->g_ac->spriteextra != 1) return 0;
+			s->g_ac->spriteextra++;
+			return 1;
+		} } },
+	{ concmd_ifwasweapon, { 1, [](ParseState* s, const int* a) -> int { return s->g_ac->picnum == a[0]; } } },
+	{ concmd_ifspawnedby, { 1, [](ParseState* s, const int* a) -> int { return s->g_ac->picnum == a[0]; } } },
+	{ concmd_ifai, comparecondition<CONCMP_TEMPEQ, 5>() },
+	{ concmd_ifaction, comparecondition<CONCMP_TEMPEQ, 4>() },
+	{ concmd_ifactioncount, comparecondition<CONCMP_TEMPGE, 2>() },
+	{ concmd_ifmove, comparecondition<CONCMP_TEMPEQ, 1>() },
+	{ concmd_ifcoop, { 0, [](ParseState* s, const int* a) -> int { return ud.coop || numplayers > 2; } } },
+	{ concmd_ifonmud, { 0, [](ParseState* s, const int* a) -> int
+		{
+			auto spr = s->g_ac->s;
+			return abs(spr->z - sector[spr->sectnum].floorz) < (32 << 8) && sector[spr->sectnum].floorpicnum == 3073; // eew, hard coded tile numbers.. :?
+		} } },
+	{ concmd_ifonwater, { 0, [](ParseState* s, const int* a) -> int
+		{
+			auto spr = s->g_ac->s;
+			return abs(spr->z - sector[spr->sectnum].floorz) < (32 << 8) && sector[spr->sectnum].lotag == ST_1_ABOVE_WATER;
+		} } },
+	{ concmd_ifmotofast, { 0, [](ParseState* s, const int* a) -> int { return ps[s->g_p].MotoSpeed > 60; } } },
+	{ concmd_ifonmoto, { 0, [](ParseState* s, const int* a) -> int { return ps[s->g_p].OnMotorcycle == 1; } } },
+	{ concmd_ifonboat, { 0, [](ParseState* s, const int* a) -> int { return ps[s->g_p].OnBoat == 1; } } },
+	{ concmd_ifsizedown, { 0, [](ParseState* s, const int* a) -> int
+		{
+			auto spr = s->g_ac->s;
+			spr->xrepeat--;
+			spr->yrepeat--;
+			return spr->xrepeat <= 5;
+		} } },
+	{ concmd_ifwind, { 0, [](ParseState* s, const int* a) -> int { return WindTime > 0; } } },
+	{ concmd_ifinwater, { 0, [](ParseState* s, const int* a) -> int { return sector[s->g_ac->s->sectnum].lotag == 2; } } },
+	{ concmd_ifcount, comparecondition<CONCMP_TEMPGE, 0>() },
+	{ concmd_ifactor, { 1, [](ParseState* s, const int* a) -> int { return s->g_ac->s->picnum == a[0]; } } },
+	{ concmd_ifp, { 1 } },
+	{ concmd_ifstrength, { 1, [](ParseState* s, const int* a) -> int { return s->g_ac->s->extra <= a[0]; } } },
+	{ concmd_ifgapzl, { 1, [](ParseState* s, const int* a) -> int { return ((s->g_ac->floorz - s->g_ac->ceilingz) >> 8) < a[0]; } } },
+	{ concmd_ifhitspace, { 0, [](ParseState* s, const int* a) -> int { return !!PlayerInput(s->g_p, SB_OPEN); } } },
+	{ concmd_ifoutside, { 0, [](ParseState* s, const int* a) -> int { return sector[s->g_ac->s->sectnum].ceilingstat & 1; } } },
+	{ concmd_ifmultiplayer, { 0, [](ParseState* s, const int* a) -> int { return ud.multimode > 1; } } },
+	{ concmd_ifinspace, { 0, [](ParseState* s, const int* a) -> int { return fi.ceilingspace(s->g_ac->s->sectnum); } } },
+	{ concmd_ifbulletnear, { 0, [](ParseState* s, const int* a) -> int { return dodge(s->g_ac) == 1; } } },
+	{ concmd_ifrespawn, { 0, [](ParseState* s, const int* a) -> int
+		{
+			if (badguy(s->g_ac)) return ud.respawn_monsters;
+			else if (inventory(s->g_ac->s)) return ud.respawn_inventory;
+			else return ud.respawn_items;
+		} } },
+	{ concmd_iffloordistl, { 1, [](ParseState* s, const int* a) -> int { return (s->g_ac->floorz - s->g_ac->s->z) <= (a[0] << 8); } } },
+	{ concmd_ifceilingdistl, { 1, [](ParseState* s, const int* a) -> int { return (s->g_ac->s->z - s->g_ac->ceilingz) <= (a[0] << 8); } } },
+	{ concmd_ifvarvare, { 2, [](ParseState* s, const int* a) -> int { return getgamevar(s, a[0]) == getgamevar(s, a[1]); } } },
+	{ concmd_ifvarvarg, { 2, [](ParseState* s, const int* a) -> int { return getgamevar(s, a[0]) > getgamevar(s, a[1]); } } },
+	{ concmd_ifvarvarl, { 2, [](ParseState* s, const int* a) -> int { return getgamevar(s, a[0]) < getgamevar(s, a[1]); } } },
+	{ concmd_ifvarvarand, { 2, [](ParseState* s, const int* a) -> int { return (getgamevar(s, a[0]) & getgamevar(s, a[1])) != 0; } } },
+	{ concmd_ifvarvarn, { 2, [](ParseState* s, const int* a) -> int { return getgamevar(s, a[0]) != getgamevar(s, a[1]); } } },
+	{ concmd_ifvare, { 2, [](ParseState* s, const int* a) -> int { return getgamevar(s, a[0]) == a[1]; } } },
+	{ concmd_ifvarg, { 2, [](ParseState* s, const int* a) -> int { return getgamevar(s, a[0]) > a[1]; } } },
+	{ concmd_ifvarl, { 2, [](ParseState* s, const int* a) -> int { return getgamevar(s, a[0]) < a[1]; } } },
+	{ concmd_ifvarn, { 2, [](ParseState* s, const int* a) -> int { return getgamevar(s, a[0]) != a[1]; } } },
+	{ concmd_ifvarand, { 2, [](ParseState* s, const int* a) -> int { return (getgamevar(s, a[0]) & a[1]) != 0; } } },
+	{ concmd_ifphealthl, { 1, [](ParseState* s, const int* a) -> int { return ps[s->g_p].GetActor()->s->extra < a[0]; } } },
+	{ concmd_ifpinventory, { 2 } },
+	{ concmd_ifawayfromwall, { 0, [](ParseState* s, const int* a) -> int
+		{
+			auto spr = s->g_ac->s;
+			short s1 = spr->sectnum;
+			updatesector(spr->x + 108, spr->y + 108, &s1);
+			if (s1 != spr->sectnum) return 0;
+			updatesector(spr->x - 108, spr->y - 108, &s1);
+			if (s1 != spr->sectnum) return 0;
+			updatesector(spr->x + 108, spr->y - 108, &s1);
+			if (s1 != spr->sectnum) return 0;
+			updatesector(spr->x - 108, spr->y + 108, &s1);
+			return s1 == spr->sectnum;
+		} } },
+	{ concmd_ifinouterspace, { 0, [](ParseState* s, const int* a) -> int { return fi.floorspace(s->g_ac->s->sectnum); } } },
+	{ concmd_ifnotmoving, { 0, [](ParseState* s, const int* a) -> int { return (s->g_ac->movflag & kHitTypeMask) > kHitSector; } } },
+	{ concmd_ifspritepal, { 1, [](ParseState* s, const int* a) -> int { return s->g_ac->s->pal == a[0]; } } },
+	{ concmd_ifangdiffl, { 1, [](ParseState* s, const int* a) -> int { return abs(getincangle(ps[s->g_p].angle.ang.asbuild(), s->g_ac->s->ang)) <= a[0]; } } },
+	{ concmd_ifnosounds, { 0, [](ParseState* s, const int* a) -> int { return !S_CheckAnyActorSoundPlaying(s->g_ac); } } },
+	{ concmd_ifplaybackon, { 0, [](ParseState* s, const int* a) -> int { return 0; } } },
+};
+
+static struct ConConditionMap
+{
+	const ConCondition* map[NUM_CONCOMMANDS] = {};
+
+	ConConditionMap()
+	{
+		for (auto& c : conditions) map[c.op] = &c.cond;
+	}
+} conditionmap;
+
+const ConCondition* GetConCondition(int op)
+{
+	if (op < 0 || op >= NUM_CONCOMMANDS) return nullptr;
+	return conditionmap.map[op];
+}
+
+//---------------------------------------------------------------------------
+//
+// Runs an 'if' command whose condition is in the table above.
+//
+//---------------------------------------------------------------------------
+
+template<bool profiled>
+void ParseState::parsecondition(int op)
+{
+	auto cond = conditionmap.map[op];
+	auto args = insptr + 1;
+	insptr += cond->numargs;
+	int result = cond->check(this, args);
+	parseifelse<profiled>(result);
+	if (cond->after) cond->after(this, result);
+}
+
 // int *it = 0x00589a04;
 
-int ParseState::parse(void)
+template<bool profiled>
+int ParseState::parsecmd(void)
 {
 	int j, l, s;
 	auto g_sp = g_ac? g_ac->s : nullptr;
 
 	if(killit_flag) return 1;
+	if constexpr (profiled) conProfileInstructions++;
 
 	switch (*insptr)
 	{
 	case concmd_ifrnd:
-	{
-		insptr++;
-		// HACK ALERT! The fire animation uses a broken ifrnd setup to delay its start because original CON has no variables.
-		// But the chosen random value of 16/255 is too low and can cause delays of a second or more.
-		int spnum = g_sp->picnum;
-		if (spnum == TILE_FIRE && g_t[4] == 0 && *insptr == 16)
-		{
-			parseifelse(rnd(64));
-			break;
-		}
-		parseifelse(rnd(*insptr));
-		break;
-	}
 	case concmd_ifcanshoottarget:
-		parseifelse(ifcanshoottarget(g_ac, g_p, g_x));
-		break;
 	case concmd_ifcanseetarget:
-		j = cansee(g_sp->x, g_sp->y, g_sp->z - ((krand() & 41) << 8), g_sp->sectnum, ps[g_p].posx, ps[g_p].posy, ps[g_p].posz/*-((krand()&41)<<8)*/, ps[g_p].GetActor()->s->sectnum);
-		parseifelse(j);
-		if (j) g_ac->timetosleep = SLEEPTIME;
-		break;
 	case concmd_ifnocover:
-		j = cansee(g_sp->x, g_sp->y, g_sp->z, g_sp->sectnum, ps[g_p].posx, ps[g_p].posy, ps[g_p].posz, ps[g_p].GetActor()->s->sectnum);
-		parseifelse(j);
-		if (j) g_ac->timetosleep = SLEEPTIME;
-		break;
-
 	case concmd_ifactornotstayput:
-		parseifelse(g_ac->actorstayput == -1);
-		break;
 	case concmd_ifcansee:
-		parseifelse(ifcansee(g_ac, g_p));
-		break;
-
 	case concmd_ifhitweapon:
-		parseifelse(fi.ifhitbyweapon(g_ac) >= 0);
-		break;
 	case concmd_ifsquished:
-		parseifelse(ifsquished(g_ac, g_p) == 1);
-		break;
 	case concmd_ifdead:
-	{
-		j = g_sp->extra;
-		if (g_sp->picnum == TILE_APLAYER)
-			j--;
-		parseifelse(j < 0);
-	}
-	break;
+	case concmd_ifpdistl:
+	case concmd_ifpdistg:
+	case concmd_ifsoundid:
+	case concmd_ifactorhealthg:
+	case concmd_ifactorhealthl:
+	case concmd_iftipcow:
+	case concmd_ifhittruck:
+	case concmd_ifwasweapon:
+	case concmd_ifspawnedby:
+	case concmd_ifai:
+	case concmd_ifaction:
+	case concmd_ifactioncount:
+	case concmd_ifmove:
+	case concmd_ifcoop:
+	case concmd_ifonmud:
+	case concmd_ifonwater:
+	case concmd_ifmotofast:
+	case concmd_ifonmoto:
+	case concmd_ifonboat:
+	case concmd_ifsizedown:
+	case concmd_ifwind:
+	case concmd_ifinwater:
+	case concmd_ifcount:
+	case concmd_ifactor:
+	case concmd_ifstrength:
+	case concmd_ifgapzl:
+	case concmd_ifhitspace:
+	case concmd_ifoutside:
+	case concmd_ifmultiplayer:
+	case concmd_ifinspace:
+	case concmd_ifbulletnear:
+	case concmd_ifrespawn:
+	case concmd_iffloordistl:
+	case concmd_ifceilingdistl:
+	case concmd_ifvarvare:
+	case concmd_ifvarvarg:
+	case concmd_ifvarvarl:
+	case concmd_ifvarvarand:
+	case concmd_ifvarvarn:
+	case concmd_ifvare:
+	case concmd_ifvarg:
+	case concmd_ifvarl:
+	case concmd_ifvarn:
+	case concmd_ifvarand:
+	case concmd_ifphealthl:
+	case concmd_ifawayfromwall:
+	case concmd_ifinouterspace:
+	case concmd_ifnotmoving:
+	case concmd_ifspritepal:
+	case concmd_ifangdiffl:
+	case concmd_ifnosounds:
+	case concmd_ifplaybackon:
+		parsecondition<profiled>(*insptr);
+		break;
+
 	case concmd_ai:
 		insptr++;
 		g_t[5] = *insptr;
@@ -1572,18 +1788,6 @@ int ParseState::parse(void)
 		insptr++;
 		break;
 
-	case concmd_ifpdistl:
-		insptr++;
-		parseifelse(g_x < *insptr);
-		if (g_x > MAXSLEEPDIST && g_ac->timetosleep == 0)
-			g_ac->timetosleep = SLEEPTIME;
-		break;
-	case concmd_ifpdistg:
-		insptr++;
-		parseifelse(g_x > * insptr);
-		if (g_x > MAXSLEEPDIST && g_ac->timetosleep == 0)
-			g_ac->timetosleep = SLEEPTIME;
-		break;
 	case concmd_else:
 		insptr = &ScriptCode[*(insptr + 1)];
 		break;
@@ -1676,15 +1880,15 @@ int ParseState::parse(void)
 					if (ps[g_p].weaprecs[j] == g_sp->picnum)
 						break;
 
-				parseifelse(j < ps[g_p].weapreccnt&& g_ac->GetOwner() == g_ac);
+				parseifelse<profiled>(j < ps[g_p].weapreccnt&& g_ac->GetOwner() == g_ac);
 			}
 			else if (ps[g_p].weapreccnt < 16)
 			{
 				ps[g_p].weaprecs[ps[g_p].weapreccnt++] = g_sp->picnum;
-				parseifelse(g_ac->GetOwner() == g_ac);
+				parseifelse<profiled>(g_ac->GetOwner() == g_ac);
 			}
 		}
-		else parseifelse(0);
+		else parseifelse<profiled>(0);
 		break;
 	case concmd_getlastpal:
 		insptr++;
@@ -1759,16 +1963,12 @@ int ParseState::parse(void)
 		fi.shoot(g_ac, (short)*insptr);
 		insptr++;
 		break;
-	case concmd_ifsoundid:
-		insptr++;
-		parseifelse((short)*insptr == ambientlotag[g_sp->ang]);
-		break;
 	case concmd_ifsounddist:
 		insptr++;
 		if (*insptr == 0)
-			parseifelse(ambienthitag[g_sp->ang] > g_x);
+			parseifelse<profiled>(ambienthitag[g_sp->ang] > g_x);
 		else if (*insptr == 1)
-			parseifelse(ambienthitag[g_sp->ang] < g_x);
+			parseifelse<profiled>(ambienthitag[g_sp->ang] < g_x);
 		break;
 	case concmd_soundtag:
 		insptr++;
@@ -1808,14 +2008,6 @@ int ParseState::parse(void)
 		ps[myconnectindex].MamaEnd = 150;
 		break;
 
-	case concmd_ifactorhealthg:
-		insptr++;
-		parseifelse(g_sp->extra > (short)*insptr);
-		break;
-	case concmd_ifactorhealthl:
-		insptr++;
-		parseifelse(g_sp->extra < (short)*insptr);
-		break;
 	case concmd_sound:
 		insptr++;
 		S_PlayActorSound((short) *insptr,g_ac);
@@ -1825,17 +2017,6 @@ int ParseState::parse(void)
 		insptr++;
 		ps[g_p].tipincs = 26;
 		break;
-	case concmd_iftipcow:
-	case concmd_ifhittruck: // both have the same code.
-		if (g_ac->spriteextra == 1) // 
-		{
-			j = 1;
-			g_ac->spriteextra++;
-		}
-		else
-			j = 0;
-		parseifelse(j > 0);
-		break;
 	case concmd_tearitup:
 		insptr++;
 		tearitup(g_sp->sectnum);
@@ -2108,14 +2289,16 @@ int ParseState::parse(void)
 	case concmd_state:
 		{
 			auto tempscrptr = insptr + 2;
-			insptr = &ScriptCode[*(insptr + 1)];
-			while (1) if (parse()) break;
+			int address = *(insptr + 1);
+			insptr = &ScriptCode[address];
+			if constexpr (profiled) ConProfile_Run(*this, CONPROFILE_STATE, address);
+			else while (1) if (parsecmd<profiled>()) break;
 			insptr = tempscrptr;
 		}
 		break;
 	case concmd_leftbrace:
 		insptr++;
-		while (1) if (parse()) break;
+		while (1) if (parsecmd<profiled>()) break;
 		break;
 	case concmd_move:
 		g_t[0]=0;
@@ -2133,23 +2316,6 @@ int ParseState::parse(void)
 			spawn(g_ac,*insptr);
 		insptr++;
 		break;
-	case concmd_ifwasweapon:
-	case concmd_ifspawnedby:	// these two are the same
-		insptr++;
-		parseifelse( g_ac->picnum == *insptr);
-		break;
-	case concmd_ifai:
-		insptr++;
-		parseifelse(g_t[5] == *insptr);
-		break;
-	case concmd_ifaction:
-		insptr++;
-		parseifelse(g_t[4] == *insptr);
-		break;
-	case concmd_ifactioncount:
-		insptr++;
-		parseifelse(g_t[2] >= *insptr);
-		break;
 	case concmd_resetactioncount:
 		insptr++;
 		g_t[2] = 0;
@@ -2207,10 +2373,6 @@ int ParseState::parse(void)
 		g_sp->picnum = (short)*insptr;
 		insptr++;
 		break;
-	case concmd_ifmove:
-		insptr++;
-		parseifelse(g_t[1] == *insptr);
-		break;
 	case concmd_resetplayer:
 		insptr++;
 
@@ -2273,44 +2435,6 @@ int ParseState::parse(void)
 			resetweapons(g_p);
 		}
 		break;
-	case concmd_ifcoop:
-		parseifelse(ud.coop || numplayers > 2);
-		break;
-	case concmd_ifonmud:
-		parseifelse(abs(g_sp->z - sector[g_sp->sectnum].floorz) < (32 << 8) && sector[g_sp->sectnum].floorpicnum == 3073); // eew, hard coded tile numbers.. :?
-		break;
-	case concmd_ifonwater:
-		parseifelse( abs(g_sp->z-sector[g_sp->sectnum].floorz) < (32<<8) && sector[g_sp->sectnum].lotag == ST_1_ABOVE_WATER);
-		break;
-	case concmd_ifmotofast:
-		parseifelse(ps[g_p].MotoSpeed > 60);
-		break;
-	case concmd_ifonmoto:
-		parseifelse(ps[g_p].OnMotorcycle == 1);
-		break;
-	case concmd_ifonboat:
-		parseifelse(ps[g_p].OnBoat == 1);
-		break;
-	case concmd_ifsizedown:
-		g_sp->xrepeat--;
-		g_sp->yrepeat--;
-		parseifelse(g_sp->xrepeat <= 5);
-		break;
-	case concmd_ifwind:
-		parseifelse(WindTime > 0);
-		break;
-
-	case concmd_ifinwater:
-		parseifelse( sector[g_sp->sectnum].lotag == 2);
-		break;
-	case concmd_ifcount:
-		insptr++;
-		parseifelse(g_t[0] >= *insptr);
-		break;
-	case concmd_ifactor:
-		insptr++;
-		parseifelse(g_sp->picnum == *insptr);
-		break;
 	case concmd_resetcount:
 		insptr++;
 		g_t[0] = 0;
@@ -2435,14 +2559,10 @@ int ParseState::parse(void)
 					j = 0;
 			}
 
-			parseifelse( j);
+			parseifelse<profiled>( j);
 
 		}
 		break;
-	case concmd_ifstrength:
-		insptr++;
-		parseifelse(g_sp->extra <= *insptr);
-		break;
 	case concmd_guts:
 		insptr += 2;
 		fi.guts(g_ac,*(insptr-1),*insptr,g_p);
@@ -2466,19 +2586,6 @@ int ParseState::parse(void)
 			ps[g_p].jumping_toggle = 1;
 		}
 		return 0;
-	case concmd_ifgapzl:
-		insptr++;
-		parseifelse( (( g_ac->floorz - g_ac->ceilingz ) >> 8 ) < *insptr);
-		break;
-	case concmd_ifhitspace:
-		parseifelse(PlayerInput(g_p, SB_OPEN));
-		break;
-	case concmd_ifoutside:
-		parseifelse(sector[g_sp->sectnum].ceilingstat & 1);
-		break;
-	case concmd_ifmultiplayer:
-		parseifelse(ud.multimode > 1);
-		break;
 	case concmd_operate:
 		insptr++;
 		if( sector[g_sp->sectnum].lotag == 0 )
@@ -2505,10 +2612,6 @@ int ParseState::parse(void)
 						}
 		}
 		break;
-	case concmd_ifinspace:
-		parseifelse(fi.ceilingspace(g_sp->sectnum));
-		break;
-
 	case concmd_spritepal:
 		insptr++;
 		if(g_sp->picnum != TILE_APLAYER)
@@ -2523,25 +2626,6 @@ int ParseState::parse(void)
 		insptr++;
 		break;
 
-	case concmd_ifbulletnear:
-		parseifelse( dodge(g_ac) == 1);
-		break;
-	case concmd_ifrespawn:
-		if( badguy(g_ac) )
-			parseifelse( ud.respawn_monsters );
-		else if( inventory(g_ac->s) )
-			parseifelse( ud.respawn_inventory );
-		else
-			parseifelse( ud.respawn_items );
-		break;
-	case concmd_iffloordistl:
-		insptr++;
-		parseifelse( (g_ac->floorz - g_sp->z) <= ((*insptr)<<8));
-		break;
-	case concmd_ifceilingdistl:
-		insptr++;
-		parseifelse( ( g_sp->z - g_ac->ceilingz ) <= ((*insptr)<<8));
-		break;
 	case concmd_palfrom:
 		insptr++;
 		SetPlayerPal(&ps[g_p], PalEntry(insptr[0], insptr[1], insptr[2], insptr[3]));
@@ -2551,7 +2635,7 @@ int ParseState::parse(void)
 /*		  case 74:
 		insptr++;
 		getglobalz(g_ac);
-		parseifelse( (( g_ac->floorz - g_ac->ceilingz ) >> 8 ) >= *insptr);
+		parseifelse<profiled>( (( g_ac->floorz - g_ac->ceilingz ) >> 8 ) >= *insptr);
 		break;
 */
 	case concmd_addlog:
@@ -2633,89 +2717,6 @@ int ParseState::parse(void)
 		insptr++;
 		break;
 	}
-	case concmd_ifvarvare:
-	{
-		int i;
-		insptr++;
-		i=*(insptr++);	// ID of def
-		j=0;
-		if(GetGameVarID(i, g_ac, g_p) == GetGameVarID(*(insptr), g_ac, g_p) )
-		{
-			j=1;
-		}
-		parseifelse( j );
-		break;
-	}
-	case concmd_ifvarvarg:
-	{
-		int i;
-		insptr++;
-		i=*(insptr++);	// ID of def
-		j=0;
-		if(GetGameVarID(i, g_ac, g_p) > GetGameVarID(*(insptr), g_ac, g_p) )
-		{
-			j=1;
-		}
-		parseifelse( j );
-		break;
-	}
-	case concmd_ifvarvarl:
-	{
-		int i;
-		insptr++;
-		i=*(insptr++);	// ID of def
-		j=0;
-		if(GetGameVarID(i, g_ac, g_p) < GetGameVarID(*(insptr), g_ac, g_p) )
-		{
-			j=1;
-		}
-		parseifelse( j );
-		break;
-	}
-	case concmd_ifvare:
-	{
-		int i;
-		insptr++;
-		i=*(insptr++);	// ID of def
-		j=0;
-		if(GetGameVarID(i, g_ac, g_p) == *insptr)
-		{
-			j=1;
-		}
-		parseifelse( j );
-		break;
-	}
-	case concmd_ifvarg:
-	{
-		int i;
-		insptr++;
-		i=*(insptr++);	// ID of def
-		j=0;
-		if(GetGameVarID(i, g_ac, g_p) > *insptr)
-		{
-			j=1;
-		}
-		parseifelse( j );
-		break;
-	}
-	case concmd_ifvarl:
-	{
-		int i;
-		insptr++;
-		i=*(insptr++);	// ID of def
-		j=0;
-		if(GetGameVarID(i, g_ac, g_p) < *insptr)
-		{
-			j=1;
-		}
-		parseifelse( j );
-		break;
-	}
-	case concmd_ifphealthl:
-		insptr++;
-		parseifelse( ps[g_p].GetActor()->s->extra < *insptr);
-		break;
-
 	case concmd_ifpinventory:
 	{
 			insptr++;
@@ -2759,7 +2760,7 @@ int ParseState::parse(void)
 					if(ps[g_p].boot_amount != *insptr) j = 1;break;
 			}
 
-			parseifelse(j);
+			parseifelse<profiled>(j);
 			break;
 		}
 	case concmd_pstomp:
@@ -2773,67 +2774,15 @@ int ParseState::parse(void)
 			ps[g_p].actorsqu = g_ac;
 		}
 		break;
-	case concmd_ifawayfromwall:
-	{
-		short s1;
-
-		s1 = g_sp->sectnum;
-
-		j = 0;
-
-		updatesector(g_sp->x + 108, g_sp->y + 108, &s1);
-		if (s1 == g_sp->sectnum)
-		{
-			updatesector(g_sp->x - 108, g_sp->y - 108, &s1);
-			if (s1 == g_sp->sectnum)
-			{
-				updatesector(g_sp->x + 108, g_sp->y - 108, &s1);
-				if (s1 == g_sp->sectnum)
-				{
-					updatesector(g_sp->x - 108, g_sp->y + 108, &s1);
-					if (s1 == g_sp->sectnum)
-						j = 1;
-				}
-			}
-		}
-		parseifelse(j);
-		break;
-	}
-
 	case concmd_quote:
 		insptr++;
 		FTA(*insptr,&ps[g_p]);
 		insptr++;
 		break;
-	case concmd_ifinouterspace:
-		parseifelse( fi.floorspace(g_sp->sectnum));
-		break;
-	case concmd_ifnotmoving:
-		parseifelse( (g_ac->movflag&kHitTypeMask) > kHitSector );
-		break;
 	case concmd_respawnhitag:
 		insptr++;
 		fi.respawnhitag(g_ac);
 		break;
-	case concmd_ifspritepal:
-		insptr++;
-		parseifelse( g_sp->pal == *insptr);
-		break;
-
-	case concmd_ifangdiffl:
-		insptr++;
-		j = abs(getincangle(ps[g_p].angle.ang.asbuild(),g_sp->ang));
-		parseifelse( j <= *insptr);
-		break;
-
-	case concmd_ifnosounds:
-		parseifelse(!S_CheckAnyActorSoundPlaying(g_ac));
-		break;
-
-	case concmd_ifplaybackon: //Twentieth Anniversary World Tour
-		parseifelse(false);
-		break;
-
 	case concmd_espawnvar:
 	{
 		DDukeActor* lReturn = nullptr;
@@ -3529,7 +3478,7 @@ int ParseState::parse(void)
 				insptr = &ScriptCode[lpCases[lCheckCase * 2 + 1]];
 				while (1)
 				{
-					if (parse())
+					if (parsecmd<profiled>())
 						break;
 				}
 				bMatched = 1;
@@ -3540,7 +3489,7 @@ int ParseState::parse(void)
 			if (*lpDefault)
 			{
 				insptr = &ScriptCode[*lpDefault];
-				while (1) if (parse()) break;
+				while (1) if (parsecmd<profiled>()) break;
 			}
 			else
 			{
@@ -3569,59 +3518,6 @@ int ParseState::parse(void)
 		SetGameVarID(g_iTextureID, sector[g_sp->sectnum].ceilingpicnum, g_ac, g_p);
 		break;
 	}
-	case concmd_ifvarvarand:
-	{
-		int i;
-		insptr++;
-		i = *(insptr++);	// ID of def
-		j = 0;
-		if (GetGameVarID(i, g_ac, g_p) & GetGameVarID(*(insptr), g_ac, g_p))
-		{
-			j = 1;
-		}
-		parseifelse(j);
-		break;
-	}
-	case concmd_ifvarvarn:
-	{
-		int i;
-		insptr++;
-		i = *(insptr++);	// ID of def
-		j = 0;
-		if (GetGameVarID(i, g_ac, g_p) != GetGameVarID(*(insptr), g_ac, g_p))
-		{
-			j = 1;
-		}
-		parseifelse(j);
-		break;
-	}
-	case concmd_ifvarn:
-	{
-		int i;
-		insptr++;
-		i = *(insptr++);	// ID of def
-		j = 0;
-		if (GetGameVarID(i, g_ac, g_p) != *insptr)
-		{
-			j = 1;
-		}
-		parseifelse(j);
-		break;
-	}
-	case concmd_ifvarand:
-	{
-		int i;
-		insptr++;
-		i = *(insptr++);	// ID of def
-		j = 0;
-		if (GetGameVarID(i, g_ac, g_p) & *insptr)
-		{
-			j = 1;
-		}
-		parseifelse(j);
-		break;
-	}
-
 	default:
 		Printf(TEXTCOLOR_RED "Unrecognized PCode of %d  in parse.  Killing current sprite.\n",*insptr);
 		Printf(TEXTCOLOR_RED "Offset=%0X\n",int(insptr-ScriptCode.Data()));
@@ -3631,6 +3527,16 @@ int ParseState::parse(void)
 	return 0;
 }
 
+int ParseState::parse(void)
+{
+	return parsecmd<false>();
+}
+
+int ParseState::parseprofiled(void)
+{
+	return parsecmd<true>();
+}
+
 //---------------------------------------------------------------------------
 //
 // 
@@ -3650,7 +3556,7 @@ void LoadActor(DDukeActor *actor, int p, int x)
 	auto addr = gs.tileinfo[actor->s->picnum].loadeventscriptptr;
 	if (addr == 0) return;
 
-	int *insptr = &ScriptCode[addr + 1];
+	s.insptr = &ScriptCode[addr];
 
 	s.killit_flag = 0;
 
@@ -3659,7 +3565,8 @@ void LoadActor(DDukeActor *actor, int p, int x)
 		deletesprite(actor);
 		return;
 	}
-	do
+	if (conProfiling) ConProfile_Run(s, CONPROFILE_LOADACTOR, actor->s->picnum);
+	else do
 		done = s.parse();
 	while (done == 0);
 
@@ -3730,8 +3637,6 @@ void execute(DDukeActor *actor,int p,int x)
 {
 	if (gs.actorinfo[actor->s->picnum].scriptaddress == 0) return;
 
-	int done;
-
 	ParseState s;
 	s.g_p = p;	// Player ID
 	s.g_x = x;	// ??
@@ -3770,9 +3675,8 @@ void execute(DDukeActor *actor,int p,int x)
 			s.g_t[3] = 0;
 	}
 
-	do
-		done = s.parse();
-	while( done == 0 );
+	if (conProfiling) ConProfile_Run(s, CONPROFILE_ACTOR, actor->s->picnum);
+	else ConCode_Run(s);
 
 	if(s.killit_flag == 1)
 	{
@@ -3817,8 +3721,6 @@ quit:
 
 void OnEvent(int iEventID, int p, DDukeActor *actor, int x)
 {
-	char done;
-
 	if (iEventID >= MAXGAMEEVENTS)
 	{
 		Printf("Invalid Event ID\n");
@@ -3838,9 +3740,8 @@ void OnEvent(int iEventID, int p, DDukeActor *actor, int x)
 	s.insptr = &ScriptCode[apScriptGameEvent[iEventID]];
 
 	s.killit_flag = 0;
-	do
-		done = s.parse();
-	while (done == 0);
+	if (conProfiling) ConProfile_Run(s, CONPROFILE_EVENT, iEventID);
+	else ConCode_Run(s);
 }
 
 END_DUKE_NS
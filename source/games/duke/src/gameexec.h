@@ -0,0 +1,67 @@
+#pragma once
+
+#include "duke3d.h"
+
+BEGIN_DUKE_NS
+
+struct ParseState
+{
+	int g_p;
+	int g_x;
+	int* g_t;
+	uint8_t killit_flag;
+	DDukeActor *g_ac;
+	int* insptr;
+	Collision coll;
+
+	int parse(void);
+	int parseprofiled(void);	// same as parse(), but counts the commands for the CON profiler.
+
+	template<bool profiled> int parsecmd(void);
+	template<bool profiled> void parseifelse(int condition);
+	template<bool profiled> void parsecondition(int op);
+};
+
+// Simple comparisons of one actor value with the command's argument.
+// The translated CON code performs these itself instead of calling 'check'.
+enum EConCompare
+{
+	CONCMP_NONE,
+	CONCMP_TEMPEQ,			// g_t[index] == arg
+	CONCMP_TEMPGE,			// g_t[index] >= arg
+	CONCMP_DISTLESS,		// g_x < arg
+	CONCMP_DISTGREATER,		// g_x > arg
+};
+
+// Conditions of the 'if' commands, split off from the branch. parse() and the native CON code both evaluate them through this.
+// 'check' may be null if the command cannot be split into condition and branch.
+struct ConCondition
+{
+	int numargs;
+	int (*check)(ParseState* s, const int* args);
+	void (*after)(ParseState* s, int result);	// side effects that happen after the branch has executed.
+	int compare = CONCMP_NONE;	// if set, 'check' does nothing but this comparison.
+	int index = 0;
+};
+
+const ConCondition* GetConCondition(int op);
+
+// condecode.cpp
+void ConCode_Run(ParseState& s);
+
+// conprofile.cpp
+enum EConProfileKind
+{
+	CONPROFILE_ACTOR,
+	CONPROFILE_LOADACTOR,
+	CONPROFILE_EVENT,
+	CONPROFILE_STATE,
+
+	NUM_CONPROFILE
+};
+
+extern bool conProfiling;
+extern uint64_t conProfileInstructions;
+void ConProfile_Run(ParseState& s, int kind, int id);
+
+END_DUKE_NS
@@ -49,6 +49,12 @@ BEGIN_DUKE_NS
 MATTGAMEVAR aGameVars[MAXGAMEVARS];
 int iGameVarCount;
 
+// All per-actor variables of one actor are stored next to each other: actorVars[spritenum * numActorVars + actorSlot]
+static TArray<int> actorVars;
+static int numActorVars;
+
+static TMap<FString, int> gameVarIndex;
+
 extern int errorcount, warningcount, line_count;
 
 //intptr_t *actorLoadEventScrptr[MAXTILES];
@@ -72,10 +78,21 @@ void SerializeGameVars(FSerializer &arc)
 				if (arc.BeginObject(gv.szLabel))
 				{
 					arc("value", gv.lValue);
-					if (gv.dwFlags & (GAMEVAR_FLAG_PERPLAYER | GAMEVAR_FLAG_PERACTOR))
+					if (gv.kind == GAMEVAR_KIND_PERPLAYER)
 					{
 						arc("array", gv.plArray);
 					}
+					else if (gv.kind == GAMEVAR_KIND_PERACTOR)
+					{
+						// Keep the savegame format of one array per variable.
+						TArray<int> values(MAXSPRITES, true);
+						for (int j = 0; j < MAXSPRITES; j++) values[j] = actorVars[j * numActorVars + gv.actorSlot];
+						arc("array", values);
+						if (arc.isReading()) for (int j = 0; j < MAXSPRITES && j < (int)values.Size(); j++)
+						{
+							actorVars[j * numActorVars + gv.actorSlot] = values[j];
+						}
+					}
 					arc.EndObject();
 				}
 			}
@@ -90,32 +107,35 @@ void SerializeGameVars(FSerializer &arc)
 //
 //---------------------------------------------------------------------------
 
+static uint8_t GameVarKind(unsigned dwFlags)
+{
+	if (dwFlags & GAMEVAR_FLAG_PERPLAYER) return GAMEVAR_KIND_PERPLAYER;
+	if (dwFlags & GAMEVAR_FLAG_PERACTOR) return GAMEVAR_KIND_PERACTOR;
+	if (dwFlags & GAMEVAR_FLAG_PLONG) return GAMEVAR_KIND_PLONG;
+	if (dwFlags & GAMEVAR_FLAG_PFUNC) return GAMEVAR_KIND_PFUNC;
+	return GAMEVAR_KIND_GLOBAL;
+}
+
 int AddGameVar(const char* pszLabel, intptr_t lValue, unsigned dwFlags)
 {
 
 	int i;
 	int j;
 
-	int b = 0;
-
 	if (dwFlags & (GAMEVAR_FLAG_PLONG | GAMEVAR_FLAG_PFUNC))
 		dwFlags |= GAMEVAR_FLAG_SYSTEM;	// force system if PLONG
 
-	for (i = 0; i < iGameVarCount; i++)
+	i = GetGameID(pszLabel);
+	if (i >= 0)
 	{
-		if (strcmp(pszLabel, aGameVars[i].szLabel) == 0)
+		// found it...
+		if (!(aGameVars[i].dwFlags & GAMEVAR_FLAG_DEFAULT) && !(aGameVars[i].dwFlags & GAMEVAR_FLAG_SYSTEM))
 		{
-			// found it...
-			if ((aGameVars[i].dwFlags & GAMEVAR_FLAG_DEFAULT)
-				|| (aGameVars[i].dwFlags & GAMEVAR_FLAG_SYSTEM)
-				)
-			{
-				// it's OK to replace
-				break;
-			}
-			else return -1;
+			return -1;
 		}
+		// it's OK to replace
 	}
+	else i = iGameVarCount;
 	if (i < MAXGAMEVARS)
 	{
 		// Set values
@@ -132,6 +152,7 @@ int AddGameVar(const char* pszLabel, intptr_t lValue, unsigned dwFlags)
 		{
 			strcpy(aGameVars[i].szLabel, pszLabel);
 			aGameVars[i].dwFlags = dwFlags;
+			aGameVars[i].kind = GameVarKind(dwFlags);
 			if (dwFlags & (GAMEVAR_FLAG_PLONG | GAMEVAR_FLAG_PFUNC))
 			{
 				aGameVars[i].plValue = (int*)lValue;
@@ -149,6 +170,7 @@ int AddGameVar(const char* pszLabel, intptr_t lValue, unsigned dwFlags)
 		if (i == iGameVarCount)
 		{
 			// we're adding a new one.
+			gameVarIndex.Insert(aGameVars[i].szLabel, i);
 			iGameVarCount++;
 		}
 		if (!(aGameVars[i].dwFlags & GAMEVAR_FLAG_SYSTEM))
@@ -166,11 +188,9 @@ int AddGameVar(const char* pszLabel, intptr_t lValue, unsigned dwFlags)
 		}
 		else if (aGameVars[i].dwFlags & GAMEVAR_FLAG_PERACTOR)
 		{
-			aGameVars[i].plArray.Resize(MAXSPRITES);
-			for (j = 0; j < MAXSPRITES; j++)
-			{
-				aGameVars[i].plArray[j] = (int)lValue;
-			}
+			// The storage gets laid out by InitGameVarPointers once all variables are known.
+			if (aGameVars[i].actorSlot < 0) aGameVars[i].actorSlot = numActorVars++;
+			actorVars.Reset();
 		}
 		return 1;
 	}
@@ -189,15 +209,8 @@ int AddGameVar(const char* pszLabel, intptr_t lValue, unsigned dwFlags)
 
 int GetGameID(const char *szGameLabel)
 {
-	int i;
-	for(i=0;i<iGameVarCount;i++)
-	{
-		if( strcmp(szGameLabel, aGameVars[i].szLabel) == 0 )
-		{
-			return i;
-		}
-	}
-	return -1;	
+	auto check = gameVarIndex.CheckKey(szGameLabel);
+	return check ? *check : -1;
 }
 
 //---------------------------------------------------------------------------
@@ -208,15 +221,7 @@ int GetGameID(const char *szGameLabel)
 
 int GetDefID(const char *szGameLabel)
 {
-	int i;
-	for(i=0;i<iGameVarCount;i++)
-	{
-		if( strcmp(szGameLabel, aGameVars[i].szLabel) == 0 )
-		{
-			return i;
-		}
-	}
-	return -1;
+	return GetGameID(szGameLabel);
 }
 
 //---------------------------------------------------------------------------
@@ -235,8 +240,13 @@ void ClearGameVars(void)
 		aGameVars[i].plValue = nullptr;
 		aGameVars[i].szLabel[0] = 0;
 		aGameVars[i].dwFlags = 0;
+		aGameVars[i].kind = GAMEVAR_KIND_GLOBAL;
+		aGameVars[i].actorSlot = -1;
 	}
 	iGameVarCount=0;
+	numActorVars = 0;
+	actorVars.Reset();
+	gameVarIndex.Clear();
 	return;
 }
 //---------------------------------------------------------------------------
@@ -248,27 +258,40 @@ void ClearGameVars(void)
 //
 //---------------------------------------------------------------------------
 
+// 'initial' lays out the storage after the CONs have been compiled. Like the
+// separate arrays this replaced, the variables then start with the value
+// passed to AddGameVar, which for GAMEVAR_FLAG_NODEFAULT is not the default.
+static void ResetActorVars(bool initial)
+{
+	// Every actor's block is the same, so build one and copy it.
+	TArray<int> defaults(numActorVars, true);
+	for (int i = 0; i < iGameVarCount; i++)
+	{
+		if (aGameVars[i].kind == GAMEVAR_KIND_PERACTOR) defaults[aGameVars[i].actorSlot] = initial ? aGameVars[i].lValue : aGameVars[i].defaultValue;
+	}
+	actorVars.Resize(numActorVars * MAXSPRITES);
+	if (numActorVars == 0) return;
+	for (int j = 0; j < MAXSPRITES; j++)
+	{
+		memcpy(&actorVars[j * numActorVars], defaults.Data(), numActorVars * sizeof(int));
+	}
+}
+
 void ResetGameVars(void)
 {
 	int i;
 
 	for(i=0;i<iGameVarCount;i++)
 	{
-		if (!(aGameVars[i].dwFlags & (GAMEVAR_FLAG_PLONG | GAMEVAR_FLAG_PFUNC)))
+		if (aGameVars[i].kind == GAMEVAR_KIND_PERPLAYER)
 		{
-			if (aGameVars[i].dwFlags & (GAMEVAR_FLAG_PERPLAYER | GAMEVAR_FLAG_PERACTOR))
-			{
-				for (auto& v : aGameVars[i].plArray)
-				{
-					v = aGameVars[i].defaultValue;
-				}
-			}
-			else if (aGameVars[i].dwFlags & GAMEVAR_FLAG_PERACTOR)
+			for (auto& v : aGameVars[i].plArray)
 			{
-				aGameVars[i].lValue = aGameVars[i].defaultValue;
+				v = aGameVars[i].defaultValue;
 			}
 		}
 	}
+	ResetActorVars(false);
 }
 
 //---------------------------------------------------------------------------
@@ -284,57 +307,39 @@ int GetGameVarID(int id, DDukeActor* sActor, int sPlayer)
 		Printf("GetGameVarID: Invalid Game ID %d\n", id);
 		return -1;
 	}
-	if (id == g_iThisActorID)
+	auto& gv = aGameVars[id];
+	switch (gv.kind)
 	{
+	case GAMEVAR_KIND_THISACTOR:
 		return sActor->GetIndex();
-	}
-	if( aGameVars[id].dwFlags & GAMEVAR_FLAG_PERPLAYER )
-	{
+
+	case GAMEVAR_KIND_PERPLAYER:
 		// for the current player
-		if(sPlayer >=0 && sPlayer < MAXPLAYERS)
-		{
-			return aGameVars[id].plArray[sPlayer];
-		}
-		else
-		{
-			return aGameVars[id].lValue;
-		}
-	}
-	else if( aGameVars[id].dwFlags & GAMEVAR_FLAG_PERACTOR )
-	{
+		if (sPlayer >= 0 && sPlayer < MAXPLAYERS) return gv.plArray[sPlayer];
+		return gv.lValue;
+
+	case GAMEVAR_KIND_PERACTOR:
 		// for the current actor
-		if(sActor != nullptr)
-		{
-			return aGameVars[id].plArray[sActor->GetIndex()];
-		}
-		else
-		{
-			return aGameVars[id].lValue;
-		}
-	}
-	else if( aGameVars[id].dwFlags & GAMEVAR_FLAG_PLONG )
-	{
-		if( !aGameVars[id].plValue)
+		if (sActor != nullptr) return actorVars[sActor->GetIndex() * numActorVars + gv.actorSlot];
+		return gv.lValue;
+
+	case GAMEVAR_KIND_PLONG:
+		if (!gv.plValue)
 		{
-			Printf("GetGameVarID NULL PlValues for PLONG Var=%s\n",aGameVars[id].szLabel);
+			Printf("GetGameVarID NULL PlValues for PLONG Var=%s\n", gv.szLabel);
 		}
+		return *gv.plValue;
 
-		return	*aGameVars[id].plValue;
-	}
-	else if (aGameVars[id].dwFlags & GAMEVAR_FLAG_PFUNC)
-	{
-		if (!aGameVars[id].plValue)
+	case GAMEVAR_KIND_PFUNC:
+		if (!gv.plValue)
 		{
-			Printf("GetGameVarID NULL PlValues for PFUNC Var=%s\n", aGameVars[id].szLabel);
+			Printf("GetGameVarID NULL PlValues for PFUNC Var=%s\n", gv.szLabel);
 		}
+		return gv.getter();
 
-		return	aGameVars[id].getter();
-	}
-	else
-	{
-		return aGameVars[id].lValue;
+	default:
+		return gv.lValue;
 	}
-	
 }
 
 //---------------------------------------------------------------------------
@@ -350,28 +355,33 @@ void SetGameVarID(int id, int lValue, DDukeActor* sActor, int sPlayer)
 		Printf("Invalid Game ID %d\n", id);
 		return;
 	}
-	if( aGameVars[id].dwFlags & GAMEVAR_FLAG_PERPLAYER )
+	auto& gv = aGameVars[id];
+	switch (gv.kind)
 	{
+	case GAMEVAR_KIND_PERPLAYER:
 		// for the current player
-		if (sPlayer >= 0) aGameVars[id].plArray[sPlayer] = lValue;
-		else for (auto& i : aGameVars[id].plArray) i = lValue; // -1 sets all players - was undefined OOB access in WW2GI.
-	}
-	else if( aGameVars[id].dwFlags & GAMEVAR_FLAG_PERACTOR )
-	{
+		if (sPlayer >= 0) gv.plArray[sPlayer] = lValue;
+		else for (auto& i : gv.plArray) i = lValue; // -1 sets all players - was undefined OOB access in WW2GI.
+		break;
+
+	case GAMEVAR_KIND_PERACTOR:
 		// for the current actor
-		if (sActor != nullptr) aGameVars[id].plArray[sActor->GetIndex()]=lValue;
-		else for (auto& i : aGameVars[id].plArray) i = lValue; // -1 sets all actors - was undefined OOB access in WW2GI.
-	}
-	else if( aGameVars[id].dwFlags & GAMEVAR_FLAG_PLONG )
-	{
+		if (sActor != nullptr) actorVars[sActor->GetIndex() * numActorVars + gv.actorSlot] = lValue;
+		else for (int j = 0; j < MAXSPRITES; j++) actorVars[j * numActorVars + gv.actorSlot] = lValue; // -1 sets all actors - was undefined OOB access in WW2GI.
+		break;
+
+	case GAMEVAR_KIND_PLONG:
 		// set the value at pointer
-		*aGameVars[id].plValue=lValue;
-	}
-	else if( !(aGameVars[id].dwFlags & GAMEVAR_FLAG_PFUNC) )
-	{
-		aGameVars[id].lValue=lValue;
+		*gv.plValue = lValue;
+		break;
+
+	case GAMEVAR_KIND_PFUNC:
+		break;
+
+	default:
+		gv.lValue = lValue;
+		break;
 	}
-	
 }
 
 //---------------------------------------------------------------------------
@@ -382,13 +392,8 @@ void SetGameVarID(int id, int lValue, DDukeActor* sActor, int sPlayer)
 
 int GetGameVar(const char *szGameLabel, int lDefault, DDukeActor* sActor, int sPlayer)
 {
-	for (int i = 0; i < iGameVarCount; i++)
-	{
-		if (strcmp(szGameLabel, aGameVars[i].szLabel) == 0)
-		{
-			return GetGameVarID(i, sActor, sPlayer);
-		}
-	}
+	int i = GetGameID(szGameLabel);
+	if (i >= 0) return GetGameVarID(i, sActor, sPlayer);
 	return lDefault;
 }
 
@@ -400,24 +405,23 @@ int GetGameVar(const char *szGameLabel, int lDefault, DDukeActor* sActor, int sP
 
 int *GetGameValuePtr(char *szGameLabel)
 {
-	int i;
-	for(i=0;i<iGameVarCount;i++)
+	int i = GetGameID(szGameLabel);
+	if (i < 0) return NULL;
+
+	if (aGameVars[i].kind == GAMEVAR_KIND_PERPLAYER)
 	{
-		if( strcmp(szGameLabel, aGameVars[i].szLabel) == 0 )
+		if(aGameVars[i].plArray.Size() == 0)
 		{
-			if(aGameVars[i].dwFlags & (GAMEVAR_FLAG_PERACTOR | GAMEVAR_FLAG_PERPLAYER))
-			{
-				if(aGameVars[i].plArray.Size() == 0)
-				{
-					Printf("INTERNAL ERROR: NULL array !!!\n");
-				}
-				return aGameVars[i].plArray.Data();
-			}
-			return &(aGameVars[i].lValue);
+			Printf("INTERNAL ERROR: NULL array !!!\n");
 		}
+		return aGameVars[i].plArray.Data();
 	}
-	return NULL;
-	
+	if (aGameVars[i].kind == GAMEVAR_KIND_PERACTOR)
+	{
+		// per-actor values are interleaved with the other variables and cannot be exposed as an array.
+		Printf("INTERNAL ERROR: %s is a per-actor variable\n", szGameLabel);
+	}
+	return &(aGameVars[i].lValue);
 }
 
 //---------------------------------------------------------------------------
@@ -494,6 +498,9 @@ void InitGameVarPointers(void)
 	char aszBuf[64];
 	// called from game Init AND when level is loaded...
 
+	// Lay out the per-actor variables once the CONs have defined all of them.
+	if (actorVars.Size() != unsigned(numActorVars * MAXSPRITES)) ResetActorVars(true);
+
 	for(i=0;i<12/*MAX_WEAPONS*/;i++)	// Setup only exists for the original 12 weapons.
 	{
 		sprintf(aszBuf,"WEAPON%d_CLIP",i);
@@ -1228,6 +1235,7 @@ void ResetSystemDefaults(void)
 	g_iHiTagID = GetGameID("HITAG");
 	g_iTextureID = GetGameID("TEXTURE");
 	g_iThisActorID = GetGameID("THISACTOR");
+	if (g_iThisActorID >= 0) aGameVars[g_iThisActorID].kind = GAMEVAR_KIND_THISACTOR;
 }
 	
 
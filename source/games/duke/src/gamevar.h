@@ -28,7 +28,18 @@ enum
 	GAMEVAR_FLAG_SYSTEM = 2048,		// cannot change mode flags...(only default value)
 	GAMEVAR_FLAG_READONLY = 4096,	// values are read-only (no setvar allowed)
 	GAMEVAR_FLAG_PLONG = 8192,		// plValue is a pointer to a long
-	GAMEVAR_FLAG_PFUNC = 8192,		// plValue is a pointer to a getter function
+	GAMEVAR_FLAG_PFUNC = 16384,		// plValue is a pointer to a getter function
+};
+
+// Storage of a variable, resolved from the flags when it gets defined so that accessing it needs only one switch.
+enum EGameVarKind : uint8_t
+{
+	GAMEVAR_KIND_GLOBAL,
+	GAMEVAR_KIND_PERPLAYER,
+	GAMEVAR_KIND_PERACTOR,
+	GAMEVAR_KIND_PLONG,
+	GAMEVAR_KIND_PFUNC,
+	GAMEVAR_KIND_THISACTOR,
 };
 
 enum
@@ -100,7 +111,9 @@ typedef struct
 	int defaultValue;
 	unsigned int dwFlags;
 	char szLabel[MAXVARLABEL];
-	TArray<int> plArray;
+	uint8_t kind;
+	int actorSlot;			// per-actor variables: index into each actor's block of variables.
+	TArray<int> plArray;	// per-player values
 } MATTGAMEVAR;
 
 extern MATTGAMEVAR aGameVars[MAXGAMEVARS];